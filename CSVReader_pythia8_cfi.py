@@ -18,7 +18,24 @@ generator = cms.EDFilter("Pythia8CSVReaderGun",
         MaxEta = cms.double(2.4),
         MinProdRadius = cms.double(0.0),
         MaxProdRadius = cms.double(10.0),
-        NumParticlesPerEvent = cms.int32(5)
+        # "E px py pz" input: rows per record, and their PDG IDs (0 if unknown) and status
+        NumParticlesPerEvent = cms.int32(5),
+        RowPdgIds = cms.vint32(0, 22, 0, 13, -13),
+        RowStatus = cms.vint32(2, 1, 2, 1, 1),
+        # particles of each record given to Pythia (any PDG ID if InjectPdgIds is empty)
+        InjectPdgIds = cms.vint32(22, 13, -13),
+        InjectStatus = cms.vint32(1),
+        # 'random': draw events at random, rejecting the ones already used in this job
+        # 'permutation': walk a permutation of the events, split in NumJobs disjoint shares; JobIndex, NumJobs
+        # and PermutationSeed have to be set for each job. PermutationSeed has to be the same for all the jobs
+        # of a production, or their shares overlap; it is independent of the seeds of the
+        # RandomNumberGeneratorService, which should still differ from one job to the next
+        SamplingMode = cms.string('random'),
+        # JobIndex = cms.uint32(0),
+        # NumJobs = cms.uint32(1),
+        # PermutationSeed = cms.uint64(12345),
+        Verbosity = cms.int32(0), # 1: log each generated event
+        SummaryInterval = cms.uint32(1000)
         ),
 
     PythiaParameters = cms.PSet(
@@ -0,0 +1,89 @@
+// Skim of the TreeMaker ntuples, see interface/SkimEngine.h
+//
+// Usage : dileptonSkim [options] "<input files>" <output file>
+//     --data          the input is data (no event weights, no gentree)
+//     --lumi <L>      integrated luminosity in /fb used for the MC weights (35.9)
+//     --pudata <f>    file with the pileup profile in data
+//     --muonsf <f>    file with the muon ID/isolation scale factors
+//     -j <n>          number of threads (0 lets ROOT decide)
+//     --all-columns   prefetch all the columns used by the selection, not only those of the first cuts
+//     --reorder-cuts  evaluate first the independent cuts that reject the most entries per unit of time
+//     --match-bits <m> bits of mhlt (TreeMaker hltMatchPaths) of the single muon trigger paths (1)
+//     --cache <d>     directory of the partial outputs, to skim again only the new or changed input files
+//
+// The wildcards in the input files have to be quoted so that they reach ROOT unexpanded
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimEngine.h"
+
+namespace {
+    void usage(const char* program) {
+        std::cerr << "Usage : " << program << " [--data] [--lumi L] [--pudata file] [--muonsf file] [-j nthreads] [--all-columns] [--reorder-cuts] [--match-bits m] [--cache dir] \"<input files>\" <output file>" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    SkimConfig config;
+
+    // Default location of the pileup and scale factor files inside the release area
+    const char* base = std::getenv("CMSSW_BASE");
+    if (base != nullptr) {
+        config.puDataFile = std::string(base) + "/src/DileptonAnalysis/AnalysisStep/data/pudata.root";
+        config.muonSFFile = std::string(base) + "/src/DileptonAnalysis/AnalysisStep/data/muonIDIsoSF.root";
+    }
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i+1 < argc);
+
+        if      (arg == "--data")               config.isMC       = false;
+        else if (arg == "--lumi"   && hasValue) config.lumi       = std::atof(argv[++i]);
+        else if (arg == "--pudata" && hasValue) config.puDataFile = argv[++i];
+        else if (arg == "--muonsf" && hasValue) config.muonSFFile = argv[++i];
+        else if (arg == "-j"       && hasValue) config.nThreads   = std::atoi(argv[++i]);
+        else if (arg == "--all-columns")        config.lazyColumns = false;
+        else if (arg == "--reorder-cuts")       config.reorderCuts = true;
+        else if (arg == "--match-bits" && hasValue) config.triggerMatchBits = std::strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--cache"  && hasValue) config.cacheDir   = argv[++i];
+        else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        }
+        else args.push_back(arg);
+    }
+
+    if (args.size() != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    config.inputFiles = args[0];
+    config.outputFile = args[1];
+
+    try {
+        SkimEngine engine(config);
+        SkimSummary summary = engine.run();
+
+        std::cout << config.outputFile << " : " << summary.nSelected << " of " << summary.nEvents << " events selected";
+        if (config.isMC) std::cout << ", weight sum " << summary.wgtsum << " over " << summary.nGenEvents << " generated events" << (summary.wgtsumFromTree ? " (gentree/tree)" : " (gentree/weights)");
+        std::cout << ", " << summary.seconds << " s" << std::endl;
+        if (not config.cacheDir.empty()) std::cout << "    " << summary.nFilesReused << " of " << summary.nFiles << " input files taken from " << config.cacheDir << std::endl;
+        std::cout << "    " << summary.bytesRead/1024. << " kB read, " << (summary.nSelected > 0 ? summary.bytesRead/1024./summary.nSelected : 0.) << " kB per selected event";
+        if (config.isMC) std::cout << ", " << summary.genBytesRead/1024. << " kB read for the weight sum";
+        std::cout << std::endl;
+        printSkimCutflow(std::cout, summary);
+    }
+    catch (const cms::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Skim of a list of samples, see interface/SkimBatch.h
+//
+// Usage : dileptonSkimSamples [options] <sample list>
+//     --outdir <d>    directory of the outputs of the samples that do not give one (.)
+//     --workers <n>   number of samples skimmed at the same time (2)
+//     --lumi <L>      integrated luminosity in /fb used for the MC weights (35.9)
+//     --pudata <f>    file with the pileup profile in data
+//     --muonsf <f>    file with the muon ID/isolation scale factors
+//     -j <n>          number of threads (0 lets ROOT decide)
+//     --all-columns   prefetch all the columns used by the selection, not only those of the first cuts
+//     --reorder-cuts  evaluate first the independent cuts that reject the most entries per unit of time
+//     --match-bits <m> bits of mhlt (TreeMaker hltMatchPaths) of the single muon trigger paths (1)
+//     --cutflow       print the per-stage cutflow and timing table of each sample
+//     --cache <d>     directory of the partial outputs (one subdirectory per sample), to skim
+//                     again only the new or changed input files
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimBatch.h"
+
+namespace {
+    void usage(const char* program) {
+        std::cerr << "Usage : " << program << " [--outdir dir] [--workers n] [--lumi L] [--pudata file] [--muonsf file] [-j nthreads] [--all-columns] [--reorder-cuts] [--match-bits m] [--cutflow] [--cache dir] <sample list>" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    SkimConfig config;
+    std::string outputDir = ".";
+    unsigned    nWorkers  = 2;
+    bool        cutflow   = false;
+
+    // Default location of the pileup and scale factor files inside the release area
+    const char* base = std::getenv("CMSSW_BASE");
+    if (base != nullptr) {
+        config.puDataFile = std::string(base) + "/src/DileptonAnalysis/AnalysisStep/data/pudata.root";
+        config.muonSFFile = std::string(base) + "/src/DileptonAnalysis/AnalysisStep/data/muonIDIsoSF.root";
+    }
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i+1 < argc);
+
+        if      (arg == "--outdir"  && hasValue) outputDir         = argv[++i];
+        else if (arg == "--workers" && hasValue) nWorkers          = std::atoi(argv[++i]);
+        else if (arg == "--lumi"    && hasValue) config.lumi       = std::atof(argv[++i]);
+        else if (arg == "--pudata"  && hasValue) config.puDataFile = argv[++i];
+        else if (arg == "--muonsf"  && hasValue) config.muonSFFile = argv[++i];
+        else if (arg == "-j"        && hasValue) config.nThreads   = std::atoi(argv[++i]);
+        else if (arg == "--all-columns")        config.lazyColumns = false;
+        else if (arg == "--reorder-cuts")        config.reorderCuts = true;
+        else if (arg == "--match-bits" && hasValue) config.triggerMatchBits = std::strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--cutflow")             cutflow            = true;
+        else if (arg == "--cache"   && hasValue) config.cacheDir   = argv[++i];
+        else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        }
+        else args.push_back(arg);
+    }
+
+    if (args.size() != 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        SkimBatch batch(readSkimSampleList(args[0], outputDir), config, nWorkers);
+        unsigned nFailed = batch.run();
+        batch.report(std::cout);
+        if (cutflow) batch.reportCutflow(std::cout);
+        if (nFailed > 0) return 1;
+    }
+    catch (const cms::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
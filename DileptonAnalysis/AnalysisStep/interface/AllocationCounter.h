@@ -0,0 +1,51 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <string>
+
+// Heap allocation instrumentation for the analyzers
+//
+// When the package is built with -DDILEPTON_COUNT_ALLOCATIONS, e.g.
+//     scram b USER_CXXFLAGS="-DDILEPTON_COUNT_ALLOCATIONS"
+// the library replaces the global operator new/delete with versions that count
+// the allocations made by each thread. For the replacement to win over the one
+// in libstdc++ the library has to be preloaded, i.e.
+//     LD_PRELOAD=$CMSSW_BASE/lib/$SCRAM_ARCH/libDileptonAnalysisAnalysisStep.so cmsRun tree_cfg.py
+// Without the flag the counter always reads 0 and the monitors stay silent.
+
+namespace AllocationCounter {
+    // Whether the counting hooks were compiled in
+    bool enabled();
+
+    // Number of operator new calls made so far by the calling thread
+    unsigned long long allocations();
+}
+
+// Accumulates the number of allocations made inside analyze() over the job
+class AllocationMonitor {
+    public:
+        AllocationMonitor(): nevents_(0), total_(0), max_(0) {}
+
+        // Counts the allocations between its construction and destruction as one event
+        class Sentry {
+            public:
+                explicit Sentry(AllocationMonitor& monitor): monitor_(monitor), start_(AllocationCounter::allocations()) {}
+                ~Sentry() { monitor_.add(AllocationCounter::allocations() - start_); }
+
+            private:
+                AllocationMonitor& monitor_;
+                unsigned long long start_;
+        };
+
+        void add(unsigned long long nallocs);
+
+        // Print the allocations per event to the "AllocationMonitor" MessageLogger category
+        void report(const std::string& label) const;
+
+    private:
+        unsigned long long nevents_;
+        unsigned long long total_;
+        unsigned long long max_;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef DEBUGTRACE_H
+#define DEBUGTRACE_H
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+// Debug trace for the AnalysisStep plugins
+//
+// Trace statements are written as
+//     DILEPTON_TRACE(trace, "Category") << "something " << value;
+// and go to the given MessageLogger category. They are compiled out unless the package
+// is built with -DDILEPTON_DEBUG_TRACE. When compiled in, the optional module parameter
+// debugTraceEvery selects the events that are traced: 0 (default) traces nothing, N traces
+// every Nth event seen by the module.
+
+class DebugTrace {
+    public:
+        explicit DebugTrace(const edm::ParameterSet& iConfig):
+            every_  (iConfig.existsAs<unsigned>("debugTraceEvery") ? iConfig.getParameter<unsigned>("debugTraceEvery") : 0),
+            nevents_(0),
+            active_ (false)
+        {
+        }
+
+        // To be called once at the start of each event
+        void nextEvent() {
+            active_ = (every_ > 0 && nevents_ % every_ == 0);
+            nevents_++;
+        }
+
+        bool active() const {
+            return active_;
+        }
+
+    private:
+        unsigned           every_;
+        unsigned long long nevents_;
+        bool               active_;
+};
+
+#ifdef DILEPTON_DEBUG_TRACE
+#define DILEPTON_TRACE(trace, category) if (not (trace).active()) ; else edm::LogVerbatim(category)
+#else
+#define DILEPTON_TRACE(trace, category) if (true) ; else edm::LogVerbatim(category)
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef DIMUONPAIRSELECTOR_H
+#define DIMUONPAIRSELECTOR_H
+
+#include <vector>
+
+#include "DataFormats/PatCandidates/interface/Muon.h"
+
+namespace edm {
+    class ParameterSet;
+}
+
+// A muon pair, given as indices in the muon collection passed to DimuonPairSelector::select
+struct DimuonPairCandidate {
+    unsigned first;
+    unsigned second;
+    float    sumPt;
+};
+
+// Builds the list of muon pairs that go into the dimuon vertex fit
+//
+// Pairs are only formed between the good muons handed to select(), and have to pass the
+// following optional preselection before any fit is attempted:
+// - requireOppositeCharge    : the two muons have opposite charges
+// - minPairDR,   maxPairDR   : window on the deltaR between the two muons
+// - minPairMass, maxPairMass : window on the invariant mass of the pair
+// A negative value disables the corresponding cut. The surviving pairs are ranked by
+// decreasing scalar pT sum and at most maxFittedPairs of them are kept (0 keeps them all).
+class DimuonPairSelector {
+    public:
+        explicit DimuonPairSelector(const edm::ParameterSet& iConfig);
+
+        // Fill pairs with the selected pairs made from the muons at the positions goodIdx in muons
+        void select(const std::vector<pat::MuonRef>& muons, const std::vector<unsigned>& goodIdx, std::vector<DimuonPairCandidate>& pairs);
+
+        // Number of pairs formed, passing the preselection, and kept after the cap in the last call to select()
+        unsigned nConsidered () const { return nConsidered_;  }
+        unsigned nPreselected() const { return nPreselected_; }
+        unsigned nSelected   () const { return nSelected_;    }
+
+    private:
+        bool     requireOppositeCharge_;
+        double   minPairDR_;
+        double   maxPairDR_;
+        double   minPairMass_;
+        double   maxPairMass_;
+        unsigned maxFittedPairs_;
+
+        unsigned nConsidered_;
+        unsigned nPreselected_;
+        unsigned nSelected_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef GENPARTICLESUMMARY_H
+#define GENPARTICLESUMMARY_H
+
+#include <cstddef>
+#include <vector>
+
+// Generator-level particles of an event, made once by GenParticleSummaryProducer for all the tree makers
+//
+// Only the particles whose |PDG ID| is in the whitelist of the producer are kept. Their quantities
+// are stored as columns, one entry per kept particle, in the order of the input collection : the
+// analyzers loop over these few entries instead of all the GEN particles, without the virtual
+// accessors of reco::GenParticle. The 4-vectors are stored as (pt, eta, phi, mass) : the mass of
+// a light particle cannot be recovered from single precision (E, px, py, pz).
+
+class GenParticleSummary {
+    public:
+        enum Flag {
+            fromHardProcessFinalState = 1,
+            isPromptFinalState        = 2,
+            isHardProcess             = 4,
+            isLastCopy                = 8
+        };
+
+        size_t size() const { return pdgId.size(); }
+
+        void clear() {
+            pdgId .clear();
+            status.clear();
+            flags .clear();
+            pt    .clear();
+            eta   .clear();
+            phi   .clear();
+            mass  .clear();
+            vx    .clear();
+            vy    .clear();
+            vz    .clear();
+            vrho  .clear();
+        }
+
+        bool hasFlag(size_t i, unsigned flag) const { return (flags[i] & flag) != 0; }
+
+        std::vector<int>            pdgId;
+        std::vector<int>            status;
+        std::vector<unsigned short> flags;
+
+        // Kinematics
+        std::vector<float>          pt, eta, phi, mass;
+
+        // Production vertex, and its transverse distance to the origin
+        std::vector<float>          vx, vy, vz, vrho;
+};
+
+#endif
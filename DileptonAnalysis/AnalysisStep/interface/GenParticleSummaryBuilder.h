@@ -0,0 +1,47 @@
+#ifndef GENPARTICLESUMMARYBUILDER_H
+#define GENPARTICLESUMMARYBUILDER_H
+
+#include <vector>
+
+#include "FWCore/Framework/interface/ConsumesCollector.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/EDGetToken.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummary.h"
+
+// Extraction of the GenParticleSummary of an event from its GEN particles
+//
+// fill() is the extraction done by GenParticleSummaryProducer. The tree makers get their summary
+// through get() : it is the GenParticleSummary product given by their genSummary parameter or,
+// for the configurations made before GenParticleSummaryProducer that only give the GEN particle
+// collection (gens), a summary extracted in the module itself, of the particles whose |PDG ID|
+// the module selects.
+
+class GenParticleSummaryBuilder {
+    public:
+        // |PDG ID| of the particles to keep, all of them if empty
+        explicit GenParticleSummaryBuilder(const std::vector<int>& pdgIds = std::vector<int>());
+
+        // Reads the genSummary product, or the gens collection if genSummary is not given,
+        // keeping then only the particles of the given |PDG ID|
+        GenParticleSummaryBuilder(const edm::ParameterSet& iConfig, edm::ConsumesCollector&& iC, const std::vector<int>& pdgIds);
+
+        void fill(const std::vector<reco::GenParticle>& gens, GenParticleSummary& summary) const;
+
+        // Summary of the event, nullptr if the product or collection is missing
+        const GenParticleSummary* get(const edm::Event& iEvent);
+
+    private:
+        bool keep(int pdgId) const;
+
+        std::vector<int>                                        pdgIds_;
+        edm::EDGetTokenT<GenParticleSummary>                    genSummaryToken_;
+        edm::EDGetTokenT<std::vector<reco::GenParticle> >       gensToken_;
+
+        // Summary extracted from the gens collection, reused from one event to the next
+        GenParticleSummary                                      summary_;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 half precision (float16) storage of floats in 16 bit integers
+//
+// Used for the per-event columns where a ~0.05% relative precision is enough, e.g. the LHE
+// weights normalized to the nominal one. Conversion rounds to the nearest representable value,
+// values beyond 65504 in magnitude become infinite.
+
+namespace HalfFloat {
+
+    inline uint16_t pack(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint16_t sign     = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        // Infinity and NaN
+        if (exponent == 0xff) return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+
+        int32_t halfExponent = int32_t(exponent) - 127 + 15;
+        if (halfExponent >= 31) return sign | 0x7c00;
+
+        // Subnormal half, or zero
+        if (halfExponent <= 0) {
+            if (halfExponent < -10) return sign;
+            mantissa |= 0x800000;
+            uint32_t shift     = 14 - halfExponent;
+            uint32_t half      = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway   = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+            return sign | half;
+        }
+
+        // Rounding may carry into the exponent, which is the correct result (up to infinity)
+        uint32_t half      = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1fff;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+        return sign | half;
+    }
+
+    inline float unpack(uint16_t half) {
+        uint32_t sign     = uint32_t(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ff;
+
+        if (exponent == 0) {
+            float value = std::ldexp(float(mantissa), -24);
+            return sign != 0 ? -value : value;
+        }
+
+        uint32_t bits;
+        if (exponent == 31) bits = sign | 0x7f800000 | (mantissa << 13);
+        else                bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+#endif
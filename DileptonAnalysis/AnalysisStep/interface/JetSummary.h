@@ -0,0 +1,60 @@
+#ifndef JETSUMMARY_H
+#define JETSUMMARY_H
+
+#include <string>
+#include <vector>
+
+#include "DataFormats/PatCandidates/interface/Jet.h"
+
+// Inputs of the jet ID, pileup ID and b-tag of the jets of an event, and the resulting ID bits
+//
+// fill() reads each jet once : |eta|, the energy fractions, the multiplicities, the pileup ID
+// discriminant and the b-tag discriminant are copied into one array per quantity, then the ID
+// bits of all the jets are evaluated in a single pass over these arrays, written without
+// branches so that the compiler can vectorize it. The b-tag discriminant is read from the
+// name/value pairs of the jet by position : the position is checked against the name on the
+// first jet of each event, searched again if it does not match, and used for the other jets of
+// the event, which share the layout of the first one. The pileup ID is a user float, which
+// pat::Jet only gives by name : it stays one userFloat() lookup per jet.
+
+class JetSummary {
+    public:
+        enum IDBit {
+            looseID        = 1,
+            tightID        = 2,
+            tightLepVetoID = 4,
+            pileupID       = 8
+        };
+
+        JetSummary(const std::string& pileupDiscriminant, const std::string& bTagDiscriminant);
+
+        void fill(const std::vector<pat::JetRef>& jets);
+
+        size_t        size() const { return absEta_.size(); }
+        unsigned char id(size_t i) const { return id_[i]; }
+        // b-tag discriminant for |eta| < 2.4, -10 otherwise
+        float         bTag(size_t i) const { return bTag_[i]; }
+
+    private:
+        // Check the cached b-tag position against the names of the jet, and search it again if it does not match
+        void checkBTagIndex(const pat::Jet& jet);
+        void evaluate();
+
+        std::string pileupDiscriminant_;
+        std::string bTagDiscriminant_;
+        // Position of the b-tag discriminant in the discriminants of the jets (-1 if not found)
+        int         bTagIndex_;
+
+        std::vector<double>        absEta_;
+        std::vector<float>         nhf_;
+        std::vector<float>         nemf_;
+        std::vector<float>         chf_;
+        std::vector<float>         muf_;
+        std::vector<int>           chm_;
+        std::vector<int>           nnp_;
+        std::vector<float>         pileupDisc_;
+        std::vector<float>         bTag_;
+        std::vector<unsigned char> id_;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LOOKUPGRID_H
+#define LOOKUPGRID_H
+
+#include <cstddef>
+#include <vector>
+
+class TH1;
+class TAxis;
+
+// Dense copy of the contents of a 1D or 2D histogram, for fast weight lookups
+//
+// The bin contents, including the underflow and overflow bins, are kept in a flat float
+// array laid out as in the histogram (global bin = binx + (nx+2) * biny). Bins are found
+// with the same convention as TAxis::FindFixBin : the position is computed directly for
+// uniform axes, and by binary search over the edges otherwise. A lookup returns what
+// hist->GetBinContent(hist->FindFixBin(x, y)) returns, rounded to float.
+
+class LookupGrid {
+    public:
+        LookupGrid();
+        explicit LookupGrid(const TH1& hist);
+
+        bool  empty() const { return values_.empty(); }
+
+        float operator()(double x) const {
+            return values_[xaxis_.find(x)];
+        }
+
+        float operator()(double x, double y) const {
+            return values_[xaxis_.find(x) + (xaxis_.nbins + 2) * yaxis_.find(y)];
+        }
+
+        // Batched lookups over n points : out[i] = value, or out[i] *= value
+        void lookup  (const float* x,                 size_t n, float* out) const;
+        void lookup  (const float* x, const float* y, size_t n, float* out) const;
+        void multiply(const float* x,                 size_t n, float* out) const;
+        void multiply(const float* x, const float* y, size_t n, float* out) const;
+
+    private:
+        struct Axis {
+            Axis();
+            explicit Axis(const TAxis& axis);
+
+            int find(double x) const {
+                if (x <  min) return 0;
+                if (x >= max) return nbins + 1;
+                if (uniform) return 1 + int(nbins * (x - min) / (max - min));
+                return findEdge(x);
+            }
+
+            int findEdge(double x) const;
+
+            int                 nbins;
+            double              min;
+            double              max;
+            bool                uniform;
+            std::vector<double> edges;
+        };
+
+        Axis               xaxis_;
+        Axis               yaxis_;
+        std::vector<float> values_;
+};
+
+#endif
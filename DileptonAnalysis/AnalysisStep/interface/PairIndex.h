@@ -0,0 +1,25 @@
+#ifndef PAIRINDEX_H
+#define PAIRINDEX_H
+
+#include <cstddef>
+
+// Layout of the per-pair vectors written by TreeMaker (masserr, pairVtxProb, ...)
+//
+// The pairs made from n objects (e.g. the muons vector) are stored in the order
+//     (0,1), (0,2), (1,2), (0,3), (1,3), (2,3), ...
+// i.e. the pair (i, j) with i < j is at slot j*(j-1)/2 + i. The slot of a pair does not
+// depend on n, and the pairs of the first n objects fill the slots 0 to n*(n-1)/2 - 1,
+// so a reader goes from the two object indices to the pair quantities without any search.
+
+// Slot of the pair (i, j), in either order, i != j
+inline std::size_t pairSlot(std::size_t i, std::size_t j) {
+    if (i > j) return j + i*(i-1)/2;
+    return i + j*(j-1)/2;
+}
+
+// Number of slots of the pairs made from n objects
+inline std::size_t nPairSlots(std::size_t n) {
+    return n > 1 ? n*(n-1)/2 : 0;
+}
+
+#endif
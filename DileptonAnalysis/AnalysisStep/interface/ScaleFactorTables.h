@@ -0,0 +1,44 @@
+#ifndef SCALEFACTORTABLES_H
+#define SCALEFACTORTABLES_H
+
+#include <memory>
+#include <string>
+
+#include "DileptonAnalysis/AnalysisStep/interface/LookupGrid.h"
+
+class TH1;
+
+// Pileup and muon scale factor tables used to weight the MC in the skim
+//
+// Built once from the data files and shared, read-only, by all the samples of a skim job
+// - pileup profile in data : "pileup" histogram of data/pudata.root
+// - muon ID and isolation scale factors vs (|eta|, pT) : "scalefactors_MuonMediumId_Muon" and
+//   "scalefactors_Iso_MuonMediumId" histograms of data/muonIDIsoSF.root
+
+class ScaleFactorTables {
+    public:
+        // Throws cms::Exception if a file or histogram is missing, or if the data pileup profile is empty
+        ScaleFactorTables(const std::string& puDataFile, const std::string& muonSFFile);
+        ~ScaleFactorTables();
+
+        // Data pileup profile, normalized to unit area
+        const TH1&  puData() const { return *puData_; }
+
+        // Data/MC ratio of the pileup profiles, vs the true number of interactions
+        // Throws cms::Exception if the MC profile is empty
+        LookupGrid  puWeights(const TH1& puMC) const;
+
+        const LookupGrid& muonID () const { return muonID_;  }
+        const LookupGrid& muonIso() const { return muonIso_; }
+
+        // Range of muon pT covered by the scale factors, values outside are moved inside
+        static double muonSFMinPt() { return  20.1; }
+        static double muonSFMaxPt() { return 119.9; }
+
+    private:
+        std::unique_ptr<TH1> puData_;
+        LookupGrid           muonID_;
+        LookupGrid           muonIso_;
+};
+
+#endif
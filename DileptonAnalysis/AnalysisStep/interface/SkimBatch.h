@@ -0,0 +1,60 @@
+#ifndef SKIMBATCH_H
+#define SKIMBATCH_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimEngine.h"
+
+// Skim of a list of samples (compiled replacement of macros/dotrim.sh)
+//
+// The samples are read from a text file with one sample per line
+//     <name> <input files> <isMC> <xsec> [<output file>]
+// where the input files may contain wildcards, isMC is 0 or 1, a negative xsec keeps the
+// cross section stored in the trees, and the output defaults to <output dir>/<name>.root.
+// Empty lines and lines starting with # are ignored.
+//
+// The pileup and scale factor tables are loaded once and shared by all the samples. Up to
+// nWorkers samples are skimmed at the same time, each one spreading the clusters of its
+// files over the ROOT implicit multithreading pool, which is sized to the machine unless
+// the base configuration asks for a given number of threads. If the base configuration has
+// a cache directory, each sample keeps its partial outputs in <cache directory>/<name>.
+
+struct SkimSample {
+    std::string name;
+    std::string inputFiles;
+    std::string outputFile;
+    bool        isMC;
+    double      xsec;
+};
+
+// Throws cms::Exception if the file cannot be read or a line is malformed
+std::vector<SkimSample> readSkimSampleList(const std::string& filename, const std::string& outputDir = ".");
+
+class SkimBatch {
+    public:
+        SkimBatch(const std::vector<SkimSample>& samples, const SkimConfig& baseConfig, unsigned nWorkers = 2);
+
+        // Skim all the samples, a failing sample does not stop the others
+        // Returns the number of samples that failed
+        unsigned run();
+
+        // Per-sample and total events, time and throughput
+        void report(std::ostream& out) const;
+
+        // Per-stage cutflow and timing table of each sample
+        void reportCutflow(std::ostream& out) const;
+
+    private:
+        std::vector<SkimSample>  samples_;
+        SkimConfig               baseConfig_;
+        unsigned                 nWorkers_;
+
+        std::vector<SkimSummary> summaries_;
+        std::vector<std::string> errors_;
+        unsigned long long       bytesRead_;
+        double                   seconds_;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef SKIMENGINE_H
+#define SKIMENGINE_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DileptonAnalysis/AnalysisStep/interface/WeightSummary.h"
+
+class TH1;
+class ScaleFactorTables;
+
+// Skim of the mmtree/tree ntuples made by TreeMaker (compiled replacement of macros/trim.C)
+//
+// The input trees are read once, in parallel over the tree clusters with TTreeProcessorMT.
+// During that pass each thread selects the dimuon events, keeps the skimmed quantities
+// in memory, and counts the MC pileup profile of the input files. The weight sum is read
+// from the gentree/weights summaries (see WeightSummary), or computed from gentree/tree
+// the same way for files made before the summaries existed. Once all the partial results
+// are merged the event weights, which depend on the full pileup profile and weight sum,
+// are computed and the skimmed tree is written out, sorted by run, lumi section and event
+// number.
+//
+// With a cache directory the skim is incremental : the selected records, pileup profile and
+// weight sum of each input file are also stored in a partial output in that directory, and
+// listed in its manifest (see SkimManifest). On the next run only the new or changed input
+// files are read, the contributions of the others are taken from their partial outputs.
+//
+// The selection is a sequence of named stages (trigger, dimuon, trigger match, mass error,
+// jets, MET and event info), each with a rough cost annotation. The entries evaluated and
+// passed, and the time spent, are counted per stage and reported in SkimSummary::stages.
+// The time is estimated from a sample of the entries (one in 64).
+
+struct SkimConfig {
+    SkimConfig();
+
+    // Input files (wildcards are allowed) and output file
+    std::string inputFiles;
+    std::string outputFile;
+
+    bool        isMC;
+
+    // Cross section used for the MC weights, if negative the xsec stored in the tree is used
+    double      xsec;
+
+    // Pileup profile in data ("pileup" histogram) and muon ID/isolation scale factors
+    std::string puDataFile;
+    std::string muonSFFile;
+
+    // Integrated luminosity (/fb) used to normalize the MC weights
+    double      lumi;
+
+    // Number of threads (0 lets ROOT decide), used if ROOT implicit multithreading is not already enabled
+    unsigned    nThreads;
+
+    // Prefetch only the columns of the trigger and dimuon cuts, and read the others (jets, MET, ...)
+    // only for the events that pass these cuts
+    bool        lazyColumns;
+
+    // Reorder the independent cuts at the start of the selection (trigger, dimuon) so that the
+    // ones rejecting the most entries per unit of time come first, based on their measured
+    // pass rate and time
+    bool        reorderCuts;
+
+    // Bits of the mhlt branch (TreeMaker hltMatchPaths) standing for the single muon trigger paths,
+    // a muon is trigger matched if it has any of them (1 : the first path of hltMatchPaths)
+    unsigned    triggerMatchBits;
+
+    // Directory of the partial outputs for incremental skims, empty to always read all the inputs
+    std::string cacheDir;
+};
+
+// Skimmed quantities of a selected event
+struct SkimRecord {
+    unsigned      run;
+    unsigned      lumSec;
+    unsigned      event;
+
+    double        wgt;
+    double        xsec;
+    unsigned char putrue;
+    unsigned char nvtx;
+
+    double        m1pt;
+    double        m1eta;
+    double        m1phi;
+    char          m1id;
+    double        m2pt;
+    double        m2eta;
+    double        m2phi;
+    char          m2id;
+    double        mmpt;
+    double        mmeta;
+    double        mmphi;
+    double        mass;
+    double        merr;
+
+    double        met;
+    double        metphi;
+
+    unsigned char njets;
+    unsigned char nbjets;
+};
+
+// Cutflow and time of a stage of the selection
+struct SkimStageStats {
+    SkimStageStats();
+
+    std::string        name;
+    // Relative cost annotation of the stage
+    unsigned           cost;
+    unsigned long long nEvaluated;
+    unsigned long long nPassed;
+    // Estimated from the entries timed, see SkimEngine
+    double             seconds;
+};
+
+struct SkimSummary {
+    SkimSummary();
+
+    unsigned           nFiles;
+    // Input files whose contribution was taken from the cache
+    unsigned           nFilesReused;
+    unsigned long long nEvents;
+    unsigned long long nSelected;
+    unsigned long long nGenEvents;
+    double             wgtsum;
+    bool               wgtsumFromTree;
+    // Bytes read from files by the whole process during the event selection (mmtree/tree), and
+    // during the sum of the generator weights (gentree)
+    unsigned long long bytesRead;
+    unsigned long long genBytesRead;
+    double             seconds;
+    // Stages of the selection, in their default order, for the input files read during the skim
+    std::vector<SkimStageStats> stages;
+};
+
+// Per-stage cutflow and timing table
+void printSkimCutflow(std::ostream& out, const SkimSummary& summary);
+
+class SkimEngine {
+    public:
+        // The pileup and scale factor tables are read from the files in config, unless given here
+        explicit SkimEngine(const SkimConfig& config, std::shared_ptr<const ScaleFactorTables> tables = std::shared_ptr<const ScaleFactorTables>());
+
+        // Run the skim, throws cms::Exception if an input cannot be read or lacks a column of the selection
+        SkimSummary run();
+
+    private:
+        // Contribution of an input file
+        struct FileResult {
+            FileResult();
+            void add(const FileResult& other);
+
+            std::vector<SkimRecord> records;
+            // Number of events per true pileup value
+            std::vector<double>     pileup;
+            unsigned long long      nEvents;
+            WeightSummary           weights;
+            bool                    wgtsumFromTree;
+        };
+
+        // Hash of the selection version and of the configuration, the partial outputs of the cache
+        // are only reused if it did not change
+        std::string              fingerprint() const;
+        std::vector<std::string> expandInputs() const;
+        void                     processFiles (const std::vector<std::string>& files, const std::vector<size_t>& toProcess, std::vector<FileResult>& results, std::vector<SkimStageStats>& stages) const;
+        void                     sumGenWeights(const std::vector<std::string>& files, const std::vector<size_t>& toProcess, std::vector<FileResult>& results) const;
+        void                     writePartial(const std::string& filename, const FileResult& result) const;
+        bool                     readPartial (const std::string& filename, FileResult& result) const;
+        void                     writeOutput(std::vector<SkimRecord>& records, const SkimSummary& summary, const TH1* puMC) const;
+
+        SkimConfig                               config_;
+        std::shared_ptr<const ScaleFactorTables> tables_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SKIMMANIFEST_H
+#define SKIMMANIFEST_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Record of the input files already skimmed, for incremental skims
+//
+// The manifest lives in a cache directory, as a tab separated text file (manifest.txt). Its
+// first line holds the fingerprint of the selection and configuration the partial outputs
+// were made with, then comes one line per input file : its size, modification time, whether
+// its weight sum came from gentree/tree, the name of the partial output holding its
+// contribution, and its path. An input file is considered unchanged, and its partial output
+// reused, if its size and modification time match the ones recorded. Files that cannot be
+// stat'ed (e.g. remote ones) are never reused. If the fingerprint differs from the one
+// given, all the entries are dropped and their partial outputs removed.
+
+class SkimManifest {
+    public:
+        struct Entry {
+            Entry();
+
+            std::string path;
+            long long   size;
+            long long   mtime;
+            bool        wgtsumFromTree;
+            std::string partialFile;
+        };
+
+        // Reads the manifest of the directory, if any, creating the directory if needed
+        SkimManifest(const std::string& directory, const std::string& fingerprint);
+
+        // Entry of the file if it is unchanged since it was recorded, nullptr otherwise
+        const Entry* find(const std::string& path) const;
+
+        // Entry for the current state of the file, with the partial output it should use
+        // Returns false if the file cannot be stat'ed
+        bool makeEntry(const std::string& path, Entry& entry) const;
+
+        void update(const Entry& entry);
+
+        // Drop the entries of the files not in the list, and remove their partial outputs
+        void retain(const std::vector<std::string>& paths);
+
+        // Throws cms::Exception if the manifest cannot be written
+        void write() const;
+
+    private:
+        std::string                  directory_;
+        std::string                  fingerprint_;
+        std::map<std::string, Entry> entries_;
+};
+
+#endif
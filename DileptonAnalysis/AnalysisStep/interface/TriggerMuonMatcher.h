@@ -0,0 +1,96 @@
+#ifndef TRIGGERMUONMATCHER_H
+#define TRIGGERMUONMATCHER_H
+
+#include <string>
+#include <vector>
+
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/VertexReco/interface/Vertex.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerObjectIndex.h"
+
+namespace edm {
+    class ParameterSet;
+}
+
+// Matching of the trigger objects of a TriggerObjectIndex to the offline muons of an event
+//
+// A trigger object and an offline muon match if
+// - matchMaxDR                         : deltaR between them is at most this (0.1)
+// - matchMinPtRatio, matchMaxPtRatio   : the ratio of the trigger object pT to the muon pT is in this window (0.5, 2)
+// A negative value disables the pT ratio cut. Each trigger object is assigned the closest
+// matching offline muon and vice versa, and each offline muon gets the OR of the path bits
+// of all the trigger objects matching it.
+//
+// The isolation and ID flags of the offline muons are computed once per event, when the
+// muons are given. Both sides are copied into arrays sorted in eta, so that the matching
+// only looks at the pairs that are within matchMaxDR in eta.
+
+class TriggerMuonMatcher {
+    public:
+        enum IDBit {
+            looseID  = 1,
+            mediumID = 2,
+            tightID  = 4
+        };
+
+        explicit TriggerMuonMatcher(const edm::ParameterSet& iConfig);
+
+        // Offline muons of the event, the tight ID is evaluated w.r.t. vertex
+        void setOfflineMuons(const std::vector<pat::Muon>&    muons, const reco::Vertex& vertex);
+        void setOfflineMuons(const std::vector<pat::MuonRef>& muons, const reco::Vertex& vertex);
+
+        void match(const TriggerObjectIndex& triggerObjects);
+
+        // Offline muon quantities, in the order the muons were given
+        // relIso is the PF isolation (cone 0.4, delta beta corrected) divided by the muon pT
+        float    relIso(size_t imu) const { return relIso_[imu]; }
+        unsigned idBits(size_t imu) const { return idBits_[imu]; }
+
+        // Position of the closest matching offline muon of trigger object itrg, and vice versa (-1 if none)
+        int      offlineMatch(size_t itrg) const { return offlineMatch_[itrg]; }
+        int      triggerMatch(size_t imu)  const { return triggerMatch_[imu];  }
+
+        // OR of the path bits of the trigger objects matching offline muon imu
+        unsigned matchedPathBits(size_t imu) const { return matchedPathBits_[imu]; }
+
+        // Log the matching statistics over the job
+        void report(const std::string& category) const;
+
+    private:
+        void clearOfflineMuons(size_t n);
+        void addOfflineMuon(const pat::Muon& muon, const reco::Vertex& vertex);
+        void sortOfflineMuons();
+
+        float maxDR_;
+        float minPtRatio_;
+        float maxPtRatio_;
+
+        // Offline muons in the order given
+        std::vector<float>    relIso_;
+        std::vector<unsigned> idBits_;
+
+        // Offline muons and trigger objects sorted in eta, with their position in the input
+        std::vector<float>    muonEta_, muonPhi_, muonPt_;
+        std::vector<unsigned> muonIdx_;
+        std::vector<float>    trgEta_, trgPhi_, trgPt_;
+        std::vector<unsigned> trgIdx_;
+        std::vector<float>    scratch_;
+
+        // Results, in the order of the inputs
+        std::vector<int>      offlineMatch_;
+        std::vector<int>      triggerMatch_;
+        std::vector<unsigned> matchedPathBits_;
+        std::vector<float>    offlineMatchDR2_;
+        std::vector<float>    triggerMatchDR2_;
+
+        // Over the job
+        unsigned long long    nEvents_;
+        unsigned long long    nTriggerObjects_;
+        unsigned long long    nOfflineMuons_;
+        unsigned long long    nPairsTested_;
+        unsigned long long    nMatchedTriggerObjects_;
+        unsigned long long    nMatchedOfflineMuons_;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef TRIGGEROBJECTINDEX_H
+#define TRIGGEROBJECTINDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h"
+
+namespace edm {
+    class TriggerNames;
+}
+
+// Index of the trigger objects of an event, built once per event
+//
+// Only the objects of the given collections (labels without the process name, e.g.
+// "hltL3MuonCandidates") are indexed, or all of them if no collection is given. They are referred to by pointer into the event product,
+// and each one gets the position of its collection in the list, and a bitmask of the given
+// paths whose last filter it passed : bit i stands for the i-th path, given without its
+// version (e.g. "HLT_IsoMu24", "HLT_IsoMu24_v" or "HLT_IsoMu24_v*" for all the versions
+// HLT_IsoMu24_v<n>, but not HLT_IsoMu24_eta2p1_v<n>), as hasPathName("HLT_IsoMu24_v*") would.
+// The path names of the HLT menu are mapped to these bits once per run by beginRun(), so that
+// the paths of an object are then decoded with one lookup per name instead of a pattern match
+// per path.
+//
+// The path names are stored packed in the MiniAOD objects, and can only be unpacked in place,
+// which the const event product does not allow : each object of the indexed collections is
+// copied once per event into a single scratch object, whose buffers are reused, and unpacked
+// there. The objects of the other collections are neither copied nor unpacked. The collection
+// label is compared only when it changes from one object to the next, the objects of a
+// collection being stored next to each other.
+
+class TriggerObjectIndex {
+    public:
+        // At most 32 paths
+        TriggerObjectIndex(const std::vector<std::string>& collections, const std::vector<std::string>& paths);
+
+        // Map the paths of the HLT menu (HLTConfigProvider::triggerNames()) to the path bits
+        void beginRun(const std::vector<std::string>& menuPaths);
+
+        void fill(const pat::TriggerObjectStandAloneCollection& objects, const edm::TriggerNames& triggerNames);
+
+        size_t                              size      ()         const { return objects_.size();   }
+        const pat::TriggerObjectStandAlone& object    (size_t i) const { return *objects_[i];      }
+        unsigned                            collection(size_t i) const { return collectionIdx_[i]; }
+        unsigned                            pathBits  (size_t i) const { return pathBits_[i];      }
+
+        static unsigned pathBit(unsigned path) { return 1u << path; }
+
+    private:
+        // Position of the collection in collections_, -1 if it is not indexed
+        int findCollection(const std::string& collection) const;
+
+        std::vector<std::string>                    collections_;
+        std::vector<std::string>                    paths_;
+        std::unordered_map<std::string, unsigned>   menuPathBits_;
+
+        std::vector<const pat::TriggerObjectStandAlone*> objects_;
+        std::vector<unsigned>                            collectionIdx_;
+        std::vector<unsigned>                            pathBits_;
+
+        pat::TriggerObjectStandAlone                     scratch_;
+};
+
+#endif
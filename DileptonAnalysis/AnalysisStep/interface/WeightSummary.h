@@ -0,0 +1,63 @@
+#ifndef WEIGHTSUMMARY_H
+#define WEIGHTSUMMARY_H
+
+#include <string>
+#include <vector>
+
+class TH1;
+
+// Totals of the generator weights of a sample
+//
+// LHEWeightsTreeMaker accumulates them over the job and stores them in the bins of a
+// small histogram (gentree/weights) next to the gentree/tree. Being a histogram the
+// summary of several files is merged by hadd, and summing the summaries of a list of
+// files gives the same totals as scanning all their gentree/tree entries.
+
+class WeightSummary {
+    public:
+        // Bins of the summary histogram
+        enum Bin {
+            nEventsBin = 1,
+            sumwBin,
+            sumw2Bin,
+            nNegativeBin,
+            nBins = nNegativeBin
+        };
+
+        WeightSummary();
+
+        void fill(double wgt) {
+            nEvents_++;
+            sumw_  += wgt;
+            sumw2_ += wgt*wgt;
+            if (wgt < 0.) nNegative_++;
+        }
+
+        void add(const WeightSummary& other);
+
+        unsigned long long nEvents  () const { return nEvents_;   }
+        unsigned long long nNegative() const { return nNegative_; }
+        double             sumw     () const { return sumw_;      }
+        double             sumw2    () const { return sumw2_;     }
+
+        // Layout of the summary histogram, to be used when booking it
+        static const char* histogramName() { return "weights"; }
+        static void        setupHistogram(TH1& hist);
+
+        // Store the totals in / add the totals read from a summary histogram
+        // The number of entries of the histogram is set to the number of events
+        void write(TH1& hist) const;
+        bool add(const TH1& hist);
+
+        // Add the summaries found in the directory dir of each file
+        // Returns false, leaving this summary untouched, if any of the files has none
+        bool add(const std::vector<std::string>& files, const std::string& dir = "gentree");
+
+    private:
+        unsigned long long nEvents_;
+        unsigned long long nNegative_;
+        double             sumw_;
+        double             sumw2_;
+};
+
+#endif
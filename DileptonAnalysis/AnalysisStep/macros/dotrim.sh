@@ -13,16 +13,21 @@ D+=( `ls -d /media/Disk1/avartak/CMS/Data/Dileptons/SingleMuon*` )
 #M+=( `ls -d /media/Disk1/avartak/CMS/Data/Dileptons/WZ*` )
 #M+=( `ls -d /media/Disk1/avartak/CMS/Data/Dileptons/ZZ*` )
 
+# Sample list for dileptonSkimSamples (built from bin/ of this package) : <name> <input files> <isMC> <xsec> <output file>
+# A negative cross section keeps the one stored in the trees
+LIST=`mktemp`
 for X in ${D[@]};
 do
-    SCRIPT=trim.C\(\"${X}/tree*.root\"\,\"${X}/trim.root\",false\)
-    root -l -b -q $SCRIPT
+    echo "`basename ${X}` ${X}/tree*.root 0 -1 ${X}/trim.root" >> ${LIST}
 done
 
 for X in ${M[@]};
 do
-    SCRIPT=trim.C\(\"${X}/tree*.root\"\,\"${X}/trim.root\",true\)
-    root -l -b -q $SCRIPT
+    echo "`basename ${X}` ${X}/tree*.root 1 -1 ${X}/trim.root" >> ${LIST}
 done
 
+# Partial outputs of the input files already skimmed, only new or changed files are read again
+CACHE=/media/Disk1/avartak/CMS/Data/Dileptons/skimcache
 
+dileptonSkimSamples --cache ${CACHE} ${LIST}
+rm -f ${LIST}
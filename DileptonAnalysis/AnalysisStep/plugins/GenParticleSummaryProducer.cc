@@ -0,0 +1,58 @@
+#include <memory>
+#include <vector>
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/global/EDProducer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummary.h"
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummaryBuilder.h"
+
+// Make the GenParticleSummary of the event : one pass over the GEN particles, shared by all the tree makers
+//
+// pdgIds : |PDG ID| of the particles to keep, all of them if empty
+
+class GenParticleSummaryProducer : public edm::global::EDProducer<> {
+    public:
+        explicit GenParticleSummaryProducer(const edm::ParameterSet&);
+        ~GenParticleSummaryProducer();
+
+        static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
+
+    private:
+        virtual void produce(edm::StreamID, edm::Event&, const edm::EventSetup&) const override;
+
+        const GenParticleSummaryBuilder builder;
+        const edm::EDGetTokenT<std::vector<reco::GenParticle> > gensToken;
+};
+
+GenParticleSummaryProducer::GenParticleSummaryProducer(const edm::ParameterSet& iConfig):
+    builder  (iConfig.existsAs<std::vector<int> >("pdgIds") ? iConfig.getParameter<std::vector<int> >("pdgIds") : std::vector<int>()),
+    gensToken(consumes<std::vector<reco::GenParticle> >(iConfig.getParameter<edm::InputTag>("gens")))
+{
+    produces<GenParticleSummary>();
+}
+
+GenParticleSummaryProducer::~GenParticleSummaryProducer() {
+}
+
+void GenParticleSummaryProducer::produce(edm::StreamID, edm::Event& iEvent, const edm::EventSetup& iSetup) const {
+    edm::Handle<std::vector<reco::GenParticle> > gensH;
+    iEvent.getByToken(gensToken, gensH);
+
+    std::unique_ptr<GenParticleSummary> summary(new GenParticleSummary());
+    if (gensH.isValid()) builder.fill(*gensH, *summary);
+
+    iEvent.put(std::move(summary));
+}
+
+void GenParticleSummaryProducer::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+    edm::ParameterSetDescription desc;
+    desc.setUnknown();
+    descriptions.addDefault(desc);
+}
+
+DEFINE_FWK_MODULE(GenParticleSummaryProducer);
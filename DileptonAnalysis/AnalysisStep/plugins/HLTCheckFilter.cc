@@ -2,18 +2,16 @@
 #include <memory>
 #include <vector>
 #include <string>
-#include <iostream>
-#include <map>
-
-// ROOT includes
-#include <TPRegexp.h>
+#include <regex>
 
 // CMSSW framework includes
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDFilter.h"
+#include "FWCore/Framework/interface/global/EDFilter.h"
 #include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/Run.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 // CMSSW data formats
 #include "DataFormats/Common/interface/TriggerResults.h"
@@ -21,91 +19,87 @@
 // Other relevant CMSSW includes
 #include "HLTrigger/HLTcore/interface/HLTConfigProvider.h"
 
-class HLTCheckFilter : public edm::EDFilter {
+// Accept the events firing any of the trigger paths matching the given patterns
+//
+// The patterns are regular expressions searched for in the path names (e.g. "HLT_IsoMu24_v"
+// for all the versions of the path), compiled once. They are matched against the paths of the
+// HLT menu at the beginning of each run, giving the list of the indices of the paths to check
+// in the trigger results. The per-event decision is a scan of that list, shared read-only by
+// all the streams.
+
+class HLTCheckFilter : public edm::global::EDFilter<edm::RunCache<std::vector<unsigned> > > {
     public:
         explicit HLTCheckFilter(const edm::ParameterSet&);
         ~HLTCheckFilter();
-        
+
         static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
-    
-    private:
-        virtual void beginJob() override;
-        virtual bool filter(edm::Event&, const edm::EventSetup&) override;
-        virtual void endJob() override;
 
-        virtual void beginRun(edm::Run const&, edm::EventSetup const&) override;
-        virtual void endRun(edm::Run const&, edm::EventSetup const&) override;
-        virtual void beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
-        virtual void endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
+    private:
+        virtual bool filter(edm::StreamID, edm::Event&, const edm::EventSetup&) const override;
 
-        // This is where we get the HLT filter results 
-        edm::InputTag triggerResultsTag;
+        virtual std::shared_ptr<std::vector<unsigned> > globalBeginRun(edm::Run const&, edm::EventSetup const&) const override;
+        virtual void globalEndRun(edm::Run const&, edm::EventSetup const&) const override;
 
-        // These are the set of trigger paths we would like to filter on
-        std::vector<std::string> triggerPathsVector;
+        // This is where we get the HLT filter results
+        const edm::InputTag triggerResultsTag;
 
-        // A map between a given trigger name and its index in the list of trigger names that fired (-1 if the trigger is not in the list)
-        std::map<std::string, int> triggerPathsMap;
+        // These are the set of trigger paths we would like to filter on, and the compiled patterns
+        const std::vector<std::string> triggerPathsVector;
+        std::vector<std::regex>        triggerPathsPatterns;
 
         // Token for the trigger results
-        edm::EDGetTokenT<edm::TriggerResults> triggerToken;
+        const edm::EDGetTokenT<edm::TriggerResults> triggerToken;
 };
 
 HLTCheckFilter::HLTCheckFilter(const edm::ParameterSet& iConfig):
-    triggerResultsTag(iConfig.getParameter<edm::InputTag>("triggerResults")),
-    triggerPathsVector(iConfig.getParameter<std::vector<std::string> >("triggerPaths"))
+    triggerResultsTag (iConfig.getParameter<edm::InputTag>("triggerResults")),
+    triggerPathsVector(iConfig.getParameter<std::vector<std::string> >("triggerPaths")),
+    triggerToken      (consumes<edm::TriggerResults> (triggerResultsTag))
 {
-    triggerToken = consumes<edm::TriggerResults> (triggerResultsTag);
+    for (const std::string& path : triggerPathsVector) {
+        try {
+            triggerPathsPatterns.emplace_back(path);
+        }
+        catch (const std::regex_error& e) {
+            throw cms::Exception("Configuration") << "Invalid trigger path pattern " << path << " : " << e.what();
+        }
+    }
 }
 
 
 HLTCheckFilter::~HLTCheckFilter() {
 }
 
-bool HLTCheckFilter::filter(edm::Event& iEvent, const edm::EventSetup& iSetup) {
-    using namespace edm;
-    using namespace std;
-
-    Handle<edm::TriggerResults> triggerResultsH;
+bool HLTCheckFilter::filter(edm::StreamID, edm::Event& iEvent, const edm::EventSetup& iSetup) const {
+    edm::Handle<edm::TriggerResults> triggerResultsH;
     iEvent.getByToken(triggerToken, triggerResultsH);
 
-    for (size_t i = 0; i < triggerPathsVector.size(); i++) {
-        if (triggerPathsMap[triggerPathsVector[i]] == -1) continue;
-        if (triggerResultsH->accept(triggerPathsMap[triggerPathsVector[i]])) return true;
+    const std::vector<unsigned>& acceptIndices = *runCache(iEvent.getRun().index());
+    for (unsigned index : acceptIndices) {
+        if (triggerResultsH->accept(index)) return true;
     }
 
     return false;
 }
 
-void HLTCheckFilter::beginJob() {
-}
-
-void HLTCheckFilter::endJob() {
-}
-
-void HLTCheckFilter::beginRun(edm::Run const& iRun , edm::EventSetup const& iSetup) { 
+std::shared_ptr<std::vector<unsigned> > HLTCheckFilter::globalBeginRun(edm::Run const& iRun , edm::EventSetup const& iSetup) const {
     HLTConfigProvider hltConfig;
     bool changedConfig = false;
     hltConfig.init(iRun, iSetup, triggerResultsTag.process(), changedConfig);
 
-    for (size_t i = 0; i < triggerPathsVector.size(); i++) triggerPathsMap[triggerPathsVector[i]] = -1;
-
-    for (size_t i = 0; i < triggerPathsVector.size(); i++) {
-        TPRegexp pattern(triggerPathsVector[i]);
-        for(size_t j = 0; j < hltConfig.triggerNames().size(); j++){
-            std::string pathName = hltConfig.triggerNames()[j];
-            if(TString(pathName).Contains(pattern)) triggerPathsMap[triggerPathsVector[i]] = j;
+    // As before, each pattern selects the last matching path of the menu
+    std::shared_ptr<std::vector<unsigned> > acceptIndices = std::make_shared<std::vector<unsigned> >();
+    for (const std::regex& pattern : triggerPathsPatterns) {
+        int index = -1;
+        for (size_t j = 0; j < hltConfig.triggerNames().size(); j++) {
+            if (std::regex_search(hltConfig.triggerNames()[j], pattern)) index = j;
         }
+        if (index >= 0) acceptIndices->push_back(index);
     }
+    return acceptIndices;
 }
 
-void HLTCheckFilter::endRun(edm::Run const&, edm::EventSetup const&) {
-}
-
-void HLTCheckFilter::beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) {
-}
-
-void HLTCheckFilter::endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) {
+void HLTCheckFilter::globalEndRun(edm::Run const&, edm::EventSetup const&) const {
 }
 
 void HLTCheckFilter::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
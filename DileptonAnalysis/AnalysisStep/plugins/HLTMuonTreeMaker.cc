@@ -31,6 +31,10 @@
 #include "HLTrigger/HLTcore/interface/HLTConfigProvider.h"
 #include "CLHEP/Random/RandFlat.h"
 #include "DileptonAnalysis/AnalysisStep/interface/CompositeCandMassResolution.h"
+#include "DileptonAnalysis/AnalysisStep/interface/AllocationCounter.h"
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummaryBuilder.h"
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerObjectIndex.h"
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerMuonMatcher.h"
 
 
 class HLTMuonTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::one::WatchRuns, edm::one::WatchLuminosityBlocks> {
@@ -60,7 +64,7 @@ class HLTMuonTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources,
         const edm::EDGetTokenT<std::vector<pat::Muon> >                muonsToken;
 
         const edm::EDGetTokenT<std::vector<PileupSummaryInfo> >        pileupInfoToken;
-        const edm::EDGetTokenT<std::vector<reco::GenParticle> >        gensToken;
+        GenParticleSummaryBuilder                                      genSummaryBuilder;
         const edm::EDGetTokenT<GenEventInfoProduct>                    genEvtInfoToken;
 
         std::vector<std::string> triggerPathsVector;
@@ -93,6 +97,17 @@ class HLTMuonTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources,
         // TTree carrying the event weight information
         TTree* tree;
 
+        // Heap allocations made per event
+        AllocationMonitor allocMonitor;
+
+        // Trigger objects stored as muons, indexed once per event
+        // - triggerObjectCollections : collections of the trigger objects stored as muons
+        // - triggerObjectPaths       : paths indexed for these objects, the muons passing the last filter of the first one are flagged in mid
+        TriggerObjectIndex triggerObjectIndex;
+
+        // Matching of the trigger objects to the offline muons, see TriggerMuonMatcher for the parameters
+        TriggerMuonMatcher muonMatcher;
+
 };
 
 HLTMuonTreeMaker::HLTMuonTreeMaker(const edm::ParameterSet& iConfig): 
@@ -102,14 +117,21 @@ HLTMuonTreeMaker::HLTMuonTreeMaker(const edm::ParameterSet& iConfig):
     verticesToken            (consumes<std::vector<reco::Vertex> >             (iConfig.getParameter<edm::InputTag>("vertices"))),
     muonsToken               (consumes<std::vector<pat::Muon> >                (iConfig.getParameter<edm::InputTag>("muons"))), 
     pileupInfoToken          (consumes<std::vector<PileupSummaryInfo> >        (iConfig.getParameter<edm::InputTag>("pileupinfo"))),
-    gensToken                (consumes<std::vector<reco::GenParticle> >        (iConfig.getParameter<edm::InputTag>("gens"))),
+    genSummaryBuilder        (iConfig, consumesCollector(), {11, 12, 13, 14, 15, 16, 23, 24, 25}),
     genEvtInfoToken          (consumes<GenEventInfoProduct>                    (iConfig.getParameter<edm::InputTag>("geneventinfo"))),
     applyHLTFilter           (iConfig.existsAs<bool>("applyHLTFilter")  ? iConfig.getParameter<bool>  ("applyHLTFilter")  : false),
     isMC                     (iConfig.existsAs<bool>("isMC")            ? iConfig.getParameter<bool>  ("isMC")            : false),
     useLHEWeights            (iConfig.existsAs<bool>("useLHEWeights")   ? iConfig.getParameter<bool>  ("useLHEWeights")   : false),
-    xsec                     (iConfig.existsAs<double>("xsec")          ? iConfig.getParameter<double>("xsec") * 1000.0   : 1.)
+    xsec                     (iConfig.existsAs<double>("xsec")          ? iConfig.getParameter<double>("xsec") * 1000.0   : 1.),
+    triggerObjectIndex       (iConfig.existsAs<std::vector<std::string> >("triggerObjectCollections") ? iConfig.getParameter<std::vector<std::string> >("triggerObjectCollections") : std::vector<std::string>(1, "hltL3MuonCandidates"),
+                              iConfig.existsAs<std::vector<std::string> >("triggerObjectPaths")       ? iConfig.getParameter<std::vector<std::string> >("triggerObjectPaths")       : std::vector<std::string>(1, "DST_DoubleMu3_Mass10_CaloScouting_PFScouting_v")),
+    muonMatcher              (iConfig)
 {
 	usesResource("TFileService");
+
+    // HLT paths
+    triggerPathsVector.push_back("HLT_PFHT800_v");
+    triggerPathsVector.push_back("DST_DoubleMu3_Mass10_CaloScouting_PFScouting_v");
 }
 
 
@@ -117,6 +139,8 @@ HLTMuonTreeMaker::~HLTMuonTreeMaker() {
 }
 
 void HLTMuonTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+    AllocationMonitor::Sentry allocSentry(allocMonitor);
+
     using namespace edm;
     using namespace reco;
     using namespace std;
@@ -140,9 +164,6 @@ void HLTMuonTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
     Handle<GenEventInfoProduct> genEvtInfoH;
     if (isMC && useLHEWeights) iEvent.getByToken(genEvtInfoToken, genEvtInfoH);
     
-    Handle<vector<GenParticle> > gensH;
-    if (isMC) iEvent.getByToken(gensToken, gensH);
-    
     muons    .clear(); mid.clear();
     gens     .clear(); gid.clear();
     
@@ -176,10 +197,11 @@ void HLTMuonTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
     if (nvtx == 0) return;
 
     // Muon information
-    const edm::TriggerNames& trigNames = iEvent.triggerNames(*triggerResultsH);
-    for (pat::TriggerObjectStandAlone trgobj : *triggerObjectsH) {
-        trgobj.unpackPathNames(trigNames);
-        if (not trgobj.hasCollection("hltL3MuonCandidates")) continue;
+    triggerObjectIndex.fill(*triggerObjectsH, iEvent.triggerNames(*triggerResultsH));
+    muonMatcher.setOfflineMuons(*muonsH, verticesH->at(0));
+    muonMatcher.match(triggerObjectIndex);
+    for (size_t itrg = 0; itrg < triggerObjectIndex.size(); itrg++) {
+        const pat::TriggerObjectStandAlone& trgobj = triggerObjectIndex.object(itrg);
 
         TLorentzVector m4;
         m4.SetPtEtaPhiM(trgobj.pt(), trgobj.eta(), trgobj.phi(), trgobj.mass());
@@ -188,14 +210,12 @@ void HLTMuonTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
         bool isMatchedToTightMu = false;
         bool isMatchedToIsoMu   = false;
         bool isMatchedToDST     = false;
-        for (auto muons_iter = muonsH->begin(); muons_iter != muonsH->end(); ++muons_iter) {
-            if (deltaR(trgobj.eta(), trgobj.phi(), muons_iter->eta(), muons_iter->phi()) > 0.1 || trgobj.pt()/muons_iter->pt() < 0.5 || trgobj.pt()/muons_iter->pt() > 2.0) continue;
-            double muonisoval = max(0., muons_iter->pfIsolationR04().sumNeutralHadronEt + muons_iter->pfIsolationR04().sumPhotonEt - 0.5*muons_iter->pfIsolationR04().sumPUPt);
-            muonisoval += muons_iter->pfIsolationR04().sumChargedHadronPt;
-            if (muonisoval/muons_iter->pt() < 0.15) isMatchedToIsoMu = true;
-            if (muons_iter->isTightMuon(verticesH->at(0)) && deltaR(trgobj.eta(), trgobj.phi(), muons_iter->eta(), muons_iter->phi()) < 0.1) isMatchedToTightMu = true;
+        int imu = muonMatcher.offlineMatch(itrg);
+        if (imu >= 0) {
+            if (muonMatcher.relIso(imu) < 0.15) isMatchedToIsoMu = true;
+            if (muonMatcher.idBits(imu) & TriggerMuonMatcher::tightID) isMatchedToTightMu = true;
         }
-        if (trgobj.hasPathName("DST_DoubleMu3_Mass10_CaloScouting_PFScouting_v*", true, false) or trgobj.hasPathName("DST_DoubleMu3_Mass10_CaloScouting_PFScouting_v*", true, true)) isMatchedToDST = true;
+        if (triggerObjectIndex.pathBits(itrg) & TriggerObjectIndex::pathBit(0)) isMatchedToDST = true;
 
         char midval = 1;
         if (isMatchedToTightMu) midval += 2;
@@ -205,20 +225,18 @@ void HLTMuonTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
         mid.push_back(midval);
     }
 
-    // GEN information
-    if (isMC && gensH.isValid()) {
-        for (auto gens_iter = gensH->begin(); gens_iter != gensH->end(); ++gens_iter) { 
-            if (gens_iter->pdgId() ==  23 || abs(gens_iter->pdgId()) == 24 || gens_iter->pdgId() == 25) {
-                TLorentzVector g4;
-                g4.SetPtEtaPhiM(gens_iter->pt(), gens_iter->eta(), gens_iter->phi(), gens_iter->mass());
-                gens.push_back(g4);
-                gid.push_back(char(gens_iter->pdgId()));
-            }
-            if (abs(gens_iter->pdgId()) > 10 && abs(gens_iter->pdgId()) < 17 && gens_iter->fromHardProcessFinalState()) {
+    // GEN information, only for the events kept
+    const GenParticleSummary* genSummaryP = isMC ? genSummaryBuilder.get(iEvent) : nullptr;
+    if (genSummaryP != nullptr) {
+        const GenParticleSummary& genSummary = *genSummaryP;
+        for (size_t i = 0; i < genSummary.size(); i++) {
+            int pdgId = genSummary.pdgId[i];
+            if ((pdgId ==  23 || abs(pdgId) == 24 || pdgId == 25) ||
+                (abs(pdgId) > 10 && abs(pdgId) < 17 && genSummary.hasFlag(i, GenParticleSummary::fromHardProcessFinalState))) {
                 TLorentzVector g4;
-                g4.SetPtEtaPhiM(gens_iter->pt(), gens_iter->eta(), gens_iter->phi(), gens_iter->mass());
+                g4.SetPtEtaPhiM(genSummary.pt[i], genSummary.eta[i], genSummary.phi[i], genSummary.mass[i]);
                 gens.push_back(g4);
-                gid.push_back(char(gens_iter->pdgId()));
+                gid.push_back(char(pdgId));
             }
         }
     }
@@ -260,13 +278,11 @@ void HLTMuonTreeMaker::beginJob() {
 }
 
 void HLTMuonTreeMaker::endJob() {
+    allocMonitor.report("HLTMuonTreeMaker");
+    muonMatcher.report("HLTMuonTreeMaker");
 }
 
 void HLTMuonTreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup) {
-    // HLT paths
-    triggerPathsVector.push_back("HLT_PFHT800_v");
-    triggerPathsVector.push_back("DST_DoubleMu3_Mass10_CaloScouting_PFScouting_v");
-
     HLTConfigProvider hltConfig;
     bool changedConfig = false;
     hltConfig.init(iRun, iSetup, triggerResultsTag.process(), changedConfig);
@@ -285,6 +301,7 @@ void HLTMuonTreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSe
         }
     }
 
+    triggerObjectIndex.beginRun(hltConfig.triggerNames());
 }
 
 void HLTMuonTreeMaker::endRun(edm::Run const&, edm::EventSetup const&) {
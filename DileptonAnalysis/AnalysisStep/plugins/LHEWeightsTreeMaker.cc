@@ -10,25 +10,54 @@
 
 // ROOT includes
 #include <TTree.h>
+#include <TH1D.h>
 
 // CMSSW framework includes
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 // CMSSW data formats
 #include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/LHERunInfoProduct.h"
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
 #include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h"
 
 // Other relevant CMSSW includes
 #include "CommonTools/UtilAlgos/interface/TFileService.h" 
-
-class LHEWeightsTreeMaker : public edm::EDAnalyzer {
+#include "DileptonAnalysis/AnalysisStep/interface/AllocationCounter.h"
+#include "DileptonAnalysis/AnalysisStep/interface/WeightSummary.h"
+#include "DileptonAnalysis/AnalysisStep/interface/HalfFloat.h"
+
+// Generator weight information of the MC events
+//
+// By default one gentree/tree entry is filled per event. With aggregateLumis = True the
+// per-event tree is not written; instead the events of each luminosity block are summed
+// up and one gentree/lumis entry is filled per luminosity block with the number of events,
+// the sum of weights and of squared weights, the number of negative weights, the true
+// pileup profile and, with storeLHEWeightSums = True, the sums of the LHE scale/PDF
+// weights (each normalized to the nominal LHE weight and multiplied by the event weight).
+// In both modes the job totals are written to gentree/weights and gentree/putrue.
+//
+// With storeLHEWeights = True the LHE scale/PDF weights, normalized to the nominal LHE
+// weight, are also stored per event in the lhewgt branch, in half precision (see HalfFloat).
+// The weights kept, per event or in the lumi block sums, are the ones listed in lheWeightIDs
+// (all of them if the list is empty). Their positions in the weight vector are looked up once
+// per run in the initrwgt header of the LHERunInfoProduct, and the IDs are written to
+// gentree/runs so that lhewgt[i] and lhesumw[i] correspond to lheids[i] of the run.
+//
+// The lumi blocks of a job are processed one after the other (and so are the events,
+// the module shares the TFileService with the other tree makers), so a single
+// accumulator reset at the beginning of each lumi block is enough.
+
+class LHEWeightsTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::one::WatchRuns, edm::one::WatchLuminosityBlocks> {
     public:
         explicit LHEWeightsTreeMaker(const edm::ParameterSet&);
         ~LHEWeightsTreeMaker();
@@ -50,12 +79,43 @@ class LHEWeightsTreeMaker : public edm::EDAnalyzer {
         const edm::EDGetTokenT<LHEEventProduct> lheInfoToken;
         const edm::EDGetTokenT<GenEventInfoProduct> genInfoToken;
         const edm::EDGetTokenT<std::vector<PileupSummaryInfo> > pileupInfoToken;
+        const edm::EDGetTokenT<LHERunInfoProduct> lheRunInfoToken;
 
         // Token to get the PU info in MC
 
         // Flag to decide whether to access and use the LHE/Gen products -- these may not be always available (e.g. we don't have them for Pythia samples)
         bool useLHEWeights;
 
+        // Flag to write one entry per luminosity block instead of one per event
+        bool aggregateLumis;
+
+        // Flag to sum the LHE scale/PDF weights per luminosity block
+        bool storeLHEWeightSums;
+
+        // Flag to store the LHE scale/PDF weights of each event
+        bool storeLHEWeights;
+
+        // IDs of the LHE weights to keep (all if empty)
+        std::vector<std::string> lheWeightIDs;
+
+        // Fill lheIDs and lheIndices from the LHE weight IDs listed in order (header or event)
+        void selectLHEWeights(const std::vector<std::string>& availableIDs);
+
+        // Check, on the first event of each run, that the event weight vector has the layout found in the
+        // run header, and write the selected IDs of the run to the runs tree
+        void checkLHEWeights(const LHEEventProduct& lheInfo);
+
+        // Selected LHE weights in the current run : IDs, and positions in LHEEventProduct::weights()
+        std::vector<std::string> lheIDs;
+        std::vector<size_t> lheIndices;
+        bool lheHeaderFound, lheIndicesChecked;
+
+        // Half precision LHE weights of the event, normalized to the nominal LHE weight
+        std::vector<uint16_t> lhewgt;
+
+        // TTree carrying the selected LHE weight IDs of each run
+        TTree* runTree;
+
         // Event weights
         double   wgtsign, wgtxsec;
 
@@ -64,14 +124,43 @@ class LHEWeightsTreeMaker : public edm::EDAnalyzer {
 
         // TTree carrying the event weight information
         TTree* tree;
+
+        // Weight totals and true pileup profile of all the events, written at the end of the job
+        // so that the skim does not need to scan the tree (see WeightSummary)
+        WeightSummary weights;
+        TH1D* weightHist;
+        TH1D* puHist;
+
+        // Per lumi block sums, and the TTree carrying them in aggregation mode
+        TTree* lumiTree;
+        unsigned run, lumSec;
+        WeightSummary lumiWeights;
+        unsigned long long lumiEvents, lumiNegative;
+        double lumiSumw, lumiSumw2;
+        std::vector<unsigned> lumiPileup;
+        std::vector<double> lumiLHESumw;
+
+        // Heap allocations made per event
+        AllocationMonitor allocMonitor;
 };
 
 LHEWeightsTreeMaker::LHEWeightsTreeMaker(const edm::ParameterSet& iConfig): 
     lheInfoToken    (consumes<LHEEventProduct>                (iConfig.getParameter<edm::InputTag>("lheInfo"))),
     genInfoToken    (consumes<GenEventInfoProduct>            (iConfig.getParameter<edm::InputTag>("genInfo"))),
     pileupInfoToken (consumes<std::vector<PileupSummaryInfo> >(iConfig.getParameter<edm::InputTag>("pileupinfo"))),
-    useLHEWeights(iConfig.getParameter<bool>("useLHEWeights"))
+    lheRunInfoToken (consumes<LHERunInfoProduct, edm::InRun>   (iConfig.existsAs<edm::InputTag>("lheRunInfo") ? iConfig.getParameter<edm::InputTag>("lheRunInfo") : edm::InputTag("externalLHEProducer"))),
+    useLHEWeights(iConfig.getParameter<bool>("useLHEWeights")),
+    aggregateLumis    (iConfig.existsAs<bool>("aggregateLumis")     ? iConfig.getParameter<bool>("aggregateLumis")     : false),
+    storeLHEWeightSums(iConfig.existsAs<bool>("storeLHEWeightSums") ? iConfig.getParameter<bool>("storeLHEWeightSums") : false),
+    storeLHEWeights   (iConfig.existsAs<bool>("storeLHEWeights")    ? iConfig.getParameter<bool>("storeLHEWeights")    : false),
+    lheWeightIDs      (iConfig.existsAs<std::vector<std::string> >("lheWeightIDs") ? iConfig.getParameter<std::vector<std::string> >("lheWeightIDs") : std::vector<std::string>()),
+    lheHeaderFound    (false),
+    lheIndicesChecked (false),
+    runTree (nullptr),
+    tree    (nullptr),
+    lumiTree(nullptr)
 {
+    usesResource("TFileService");
 }
 
 
@@ -79,6 +168,8 @@ LHEWeightsTreeMaker::~LHEWeightsTreeMaker() {
 }
 
 void LHEWeightsTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+    AllocationMonitor::Sentry allocSentry(allocMonitor);
+
     using namespace edm;
     using namespace std;
 
@@ -108,8 +199,33 @@ void LHEWeightsTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetu
         }
     }
 
-    // Fill the tree
-    tree->Fill();
+    // LHE scale/PDF weights, normalized to the nominal LHE weight
+    bool storeLHE = useLHEWeights && ((aggregateLumis && storeLHEWeightSums) || (not aggregateLumis && storeLHEWeights));
+    lhewgt.clear();
+    if (storeLHE && lheInfoH->originalXWGTUP() != 0.) {
+        if (not lheIndicesChecked) checkLHEWeights(*lheInfoH);
+
+        const vector<gen::WeightsInfo>& lheWeights = lheInfoH->weights();
+        if (aggregateLumis) {
+            lumiLHESumw.resize(lheIndices.size(), 0.);
+            for (size_t i = 0; i < lheIndices.size(); i++) lumiLHESumw[i] += wgtsign * lheWeights[lheIndices[i]].wgt / lheInfoH->originalXWGTUP();
+        }
+        else {
+            lhewgt.resize(lheIndices.size());
+            for (size_t i = 0; i < lheIndices.size(); i++) lhewgt[i] = HalfFloat::pack(lheWeights[lheIndices[i]].wgt / lheInfoH->originalXWGTUP());
+        }
+    }
+
+    // Fill the tree, or add the event to the lumi block sums
+    if (not aggregateLumis) tree->Fill();
+    else {
+        lumiWeights.fill(wgtsign);
+        if (lumiPileup.size() <= putrue) lumiPileup.resize(putrue+1, 0);
+        lumiPileup[putrue]++;
+    }
+
+    weights.fill(wgtsign);
+    puHist->Fill(putrue);
 
 }
 
@@ -119,7 +235,32 @@ void LHEWeightsTreeMaker::beginJob() {
     edm::Service<TFileService> fs;
 
     // Create the TTree
-    tree = fs->make<TTree>("tree"       , "tree");
+    if (aggregateLumis) {
+        lumiTree = fs->make<TTree>("lumis", "lumis");
+
+        lumiTree->Branch("run"              , &run                  , "run/i"    );
+        lumiTree->Branch("lumSec"           , &lumSec               , "lumSec/i" );
+        lumiTree->Branch("nevents"          , &lumiEvents           , "nevents/l");
+        lumiTree->Branch("sumw"             , &lumiSumw             , "sumw/D"   );
+        lumiTree->Branch("sumw2"            , &lumiSumw2            , "sumw2/D"  );
+        lumiTree->Branch("nneg"             , &lumiNegative         , "nneg/l"   );
+        lumiTree->Branch("putrue"           , "std::vector<unsigned>", &lumiPileup);
+        if (storeLHEWeightSums) lumiTree->Branch("lhesumw", "std::vector<double>", &lumiLHESumw);
+    }
+    else tree = fs->make<TTree>("tree"       , "tree");
+
+    // Summary of the weights and pileup profile
+    weightHist = fs->make<TH1D>(WeightSummary::histogramName(), "Generator weight totals", WeightSummary::nBins, 0., WeightSummary::nBins);
+    WeightSummary::setupHistogram(*weightHist);
+    puHist     = fs->make<TH1D>("putrue", "True number of pileup interactions", 256, 0., 256.);
+
+    if (storeLHEWeightSums || storeLHEWeights) {
+        runTree = fs->make<TTree>("runs", "runs");
+        runTree->Branch("run"               , &run                  , "run/i"    );
+        runTree->Branch("lheids"            , "std::vector<std::string>", &lheIDs);
+    }
+
+    if (aggregateLumis) return;
 
     // Create the branches for the event weights
     tree->Branch("wgtsign"              , &wgtsign              , "wgtsign/D");
@@ -127,21 +268,108 @@ void LHEWeightsTreeMaker::beginJob() {
 
     // Pileup info
     tree->Branch("putrue"               , &putrue               , "putrue/b" );
+
+    // LHE weights
+    if (storeLHEWeights) tree->Branch("lhewgt", "std::vector<unsigned short>", &lhewgt);
 }
 
 void LHEWeightsTreeMaker::endJob() {
+    weights.write(*weightHist);
+    allocMonitor.report("LHEWeightsTreeMaker");
 }
 
 void LHEWeightsTreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup) {
+    if (runTree == nullptr || not useLHEWeights) return;
+
+    // IDs of the LHE weights, in the order of the weight vector, from the <weight id="..."> lines of the initrwgt header
+    std::vector<std::string> headerIDs;
+    edm::Handle<LHERunInfoProduct> lheRunInfoH;
+    iRun.getByToken(lheRunInfoToken, lheRunInfoH);
+    if (lheRunInfoH.isValid()) {
+        for (auto header = lheRunInfoH->headers_begin(); header != lheRunInfoH->headers_end(); ++header) {
+            if (header->tag() != "initrwgt") continue;
+            for (const std::string& line : header->lines()) {
+                size_t start = line.find("<weight");
+                if (start == std::string::npos || start+7 >= line.size()) continue;
+                if (line[start+7] != ' ' && line[start+7] != '\t' && line[start+7] != '>') continue;
+
+                size_t idpos = line.find("id=", start);
+                if (idpos == std::string::npos || idpos+4 >= line.size()) continue;
+                char quote = line[idpos+3];
+                size_t end = line.find(quote, idpos+4);
+                if (end == std::string::npos) continue;
+                headerIDs.push_back(line.substr(idpos+4, end-idpos-4));
+            }
+        }
+    }
+
+    // Without a header the layout is taken from the first event of the run
+    run = iRun.run();
+    lheHeaderFound = not headerIDs.empty();
+    selectLHEWeights(headerIDs);
+    lheIndicesChecked = false;
+}
+
+void LHEWeightsTreeMaker::selectLHEWeights(const std::vector<std::string>& availableIDs) {
+    lheIDs.clear();
+    lheIndices.clear();
+
+    if (lheWeightIDs.empty()) {
+        lheIDs = availableIDs;
+        for (size_t i = 0; i < availableIDs.size(); i++) lheIndices.push_back(i);
+        return;
+    }
+
+    for (const std::string& id : lheWeightIDs) {
+        auto found = std::find(availableIDs.begin(), availableIDs.end(), id);
+        if (found == availableIDs.end()) {
+            if (not availableIDs.empty()) edm::LogWarning("LHEWeightsTreeMaker") << "No LHE weight with ID " << id << " in run " << run;
+            continue;
+        }
+        lheIDs.push_back(id);
+        lheIndices.push_back(found - availableIDs.begin());
+    }
+}
+
+void LHEWeightsTreeMaker::checkLHEWeights(const LHEEventProduct& lheInfo) {
+    lheIndicesChecked = true;
+
+    const std::vector<gen::WeightsInfo>& lheWeights = lheInfo.weights();
+    bool consistent = lheHeaderFound;
+    for (size_t i = 0; i < lheIndices.size() && consistent; i++) {
+        if (lheIndices[i] >= lheWeights.size() || lheWeights[lheIndices[i]].id != lheIDs[i]) consistent = false;
+    }
+
+    if (not consistent) {
+        if (lheHeaderFound) edm::LogWarning("LHEWeightsTreeMaker") << "LHE weights of run " << run << " do not follow the run header, using the layout of the first event";
+        std::vector<std::string> eventIDs;
+        for (const gen::WeightsInfo& weight : lheWeights) eventIDs.push_back(weight.id);
+        selectLHEWeights(eventIDs);
+    }
+
+    runTree->Fill();
+    edm::LogInfo("LHEWeightsTreeMaker") << "Run " << run << " : " << lheIDs.size() << " LHE weights kept";
 }
 
 void LHEWeightsTreeMaker::endRun(edm::Run const&, edm::EventSetup const&) {
 }
 
 void LHEWeightsTreeMaker::beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) {
+    lumiWeights = WeightSummary();
+    lumiPileup.clear();
+    lumiLHESumw.clear();
 }
 
-void LHEWeightsTreeMaker::endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) {
+void LHEWeightsTreeMaker::endLuminosityBlock(edm::LuminosityBlock const& iLumi, edm::EventSetup const&) {
+    if (not aggregateLumis) return;
+
+    run          = iLumi.run();
+    lumSec       = iLumi.luminosityBlock();
+    lumiEvents   = lumiWeights.nEvents();
+    lumiSumw     = lumiWeights.sumw();
+    lumiSumw2    = lumiWeights.sumw2();
+    lumiNegative = lumiWeights.nNegative();
+    lumiTree->Fill();
 }
 
 void LHEWeightsTreeMaker::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
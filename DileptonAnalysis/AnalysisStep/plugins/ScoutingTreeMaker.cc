@@ -18,7 +18,6 @@
 
 // CMSSW data formats
 #include "DataFormats/Math/interface/deltaR.h"
-#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 #include "DataFormats/Scouting/interface/ScoutingMuon.h"
 #include "DataFormats/Scouting/interface/ScoutingParticle.h"
 #include "DataFormats/Scouting/interface/ScoutingVertex.h"
@@ -32,6 +31,8 @@
 // Other relevant CMSSW includes
 #include "CommonTools/UtilAlgos/interface/TFileService.h" 
 #include "HLTrigger/HLTcore/interface/HLTConfigProvider.h"
+#include "DileptonAnalysis/AnalysisStep/interface/AllocationCounter.h"
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummaryBuilder.h"
 
 
 class ScoutingTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::one::WatchRuns, edm::one::WatchLuminosityBlocks> {
@@ -60,7 +61,7 @@ class ScoutingTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources,
         const edm::EDGetTokenT<double>                          rhoToken;
 
         const edm::EDGetTokenT<std::vector<PileupSummaryInfo> > pileupInfoToken;
-        const edm::EDGetTokenT<std::vector<reco::GenParticle> > gensToken;
+        GenParticleSummaryBuilder                               genSummaryBuilder;
         const edm::EDGetTokenT<GenEventInfoProduct>             genEvtInfoToken;
 
         std::vector<std::string> triggerPathsVector;
@@ -120,6 +121,9 @@ class ScoutingTreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources,
         // TTree carrying the event weight information
         TTree* tree;
 
+        // Heap allocations made per event
+        AllocationMonitor allocMonitor;
+
 };
 
 ScoutingTreeMaker::ScoutingTreeMaker(const edm::ParameterSet& iConfig): 
@@ -130,7 +134,7 @@ ScoutingTreeMaker::ScoutingTreeMaker(const edm::ParameterSet& iConfig):
     pfcandsToken             (consumes<std::vector<ScoutingParticle> >         (iConfig.getParameter<edm::InputTag>("pfcands"))), 
     rhoToken                 (consumes<double>                                 (iConfig.getParameter<edm::InputTag>("rho"))), 
     pileupInfoToken          (consumes<std::vector<PileupSummaryInfo> >        (iConfig.getParameter<edm::InputTag>("pileupinfo"))),
-    gensToken                (consumes<std::vector<reco::GenParticle> >        (iConfig.getParameter<edm::InputTag>("gens"))),
+    genSummaryBuilder        (iConfig, consumesCollector(), {11, 12, 13, 14, 15, 16, 23, 24, 25, 1023}),
     genEvtInfoToken          (consumes<GenEventInfoProduct>                    (iConfig.getParameter<edm::InputTag>("geneventinfo"))),
     isMC                     (iConfig.existsAs<bool>("isMC")               ?    iConfig.getParameter<bool>  ("isMC")            : false),
     useLHEWeights            (iConfig.existsAs<bool>("useLHEWeights")      ?    iConfig.getParameter<bool>  ("useLHEWeights")   : false),
@@ -147,6 +151,8 @@ ScoutingTreeMaker::~ScoutingTreeMaker() {
 }
 
 void ScoutingTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+    AllocationMonitor::Sentry allocSentry(allocMonitor);
+
     using namespace edm;
     using namespace std;
     using namespace reco;
@@ -173,9 +179,6 @@ void ScoutingTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
     Handle<GenEventInfoProduct> genEvtInfoH;
     if (isMC && useLHEWeights) iEvent.getByToken(genEvtInfoToken, genEvtInfoH);
     
-    Handle<vector<GenParticle> > gensH;
-    if (isMC) iEvent.getByToken(gensToken, gensH);
-    
     // Event information - MC weight, event ID (run, lumi, event) and so on
     wgt = 1.0;
     if (isMC && useLHEWeights && genEvtInfoH.isValid()) wgt = genEvtInfoH->weight(); 
@@ -298,21 +301,18 @@ void ScoutingTreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup&
 
     if (require2Muons && muonpt.size() < 2) return;
 
-    // GEN information
-    if (isMC && gensH.isValid()) {
-        for (auto gens_iter = gensH->begin(); gens_iter != gensH->end(); ++gens_iter) {
-            if (gens_iter->pdgId() ==  23 || abs(gens_iter->pdgId()) == 24 || gens_iter->pdgId() == 25 || gens_iter->pdgId() == 1023) {
+    // GEN information, only for the events kept
+    const GenParticleSummary* genSummaryP = isMC ? genSummaryBuilder.get(iEvent) : nullptr;
+    if (genSummaryP != nullptr) {
+        const GenParticleSummary& genSummary = *genSummaryP;
+        for (size_t i = 0; i < genSummary.size(); i++) {
+            int pdgId = genSummary.pdgId[i];
+            if ((pdgId ==  23 || abs(pdgId) == 24 || pdgId == 25 || pdgId == 1023) ||
+                (abs(pdgId) > 10 && abs(pdgId) < 17 && genSummary.hasFlag(i, GenParticleSummary::fromHardProcessFinalState))) {
                 TLorentzVector g4;
-                g4.SetPtEtaPhiM(gens_iter->pt(), gens_iter->eta(), gens_iter->phi(), gens_iter->mass());
+                g4.SetPtEtaPhiM(genSummary.pt[i], genSummary.eta[i], genSummary.phi[i], genSummary.mass[i]);
                 gens.push_back(g4);
-                gid.push_back(char(gens_iter->pdgId()));
-            }
-            if (abs(gens_iter->pdgId()) > 10 && abs(gens_iter->pdgId()) < 17 && gens_iter->fromHardProcessFinalState()) {
-                TLorentzVector g4;
-                g4.SetPtEtaPhiM(gens_iter->pt(), gens_iter->eta(), gens_iter->phi(), gens_iter->mass());
-                gens.push_back(g4);
-                gid.push_back(char(gens_iter->pdgId()));
-
+                gid.push_back(char(pdgId));
             }
         }
     }
@@ -374,6 +374,7 @@ void ScoutingTreeMaker::beginJob() {
 }
 
 void ScoutingTreeMaker::endJob() {
+    allocMonitor.report("ScoutingTreeMaker");
 }
 
 void ScoutingTreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup) {
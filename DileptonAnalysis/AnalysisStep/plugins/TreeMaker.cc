@@ -2,6 +2,7 @@
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <iomanip>
 
 // ROOT includes
 #include <TTree.h>
@@ -13,6 +14,7 @@
 #include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
 #include "FWCore/Utilities/interface/RandomNumberGenerator.h"
@@ -35,6 +37,14 @@
 #include "HLTrigger/HLTcore/interface/HLTConfigProvider.h"
 #include "CLHEP/Random/RandFlat.h"
 #include "DileptonAnalysis/AnalysisStep/interface/CompositeCandMassResolution.h"
+#include "DileptonAnalysis/AnalysisStep/interface/AllocationCounter.h"
+#include "DileptonAnalysis/AnalysisStep/interface/DebugTrace.h"
+#include "DileptonAnalysis/AnalysisStep/interface/DimuonPairSelector.h"
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummaryBuilder.h"
+#include "DileptonAnalysis/AnalysisStep/interface/JetSummary.h"
+#include "DileptonAnalysis/AnalysisStep/interface/PairIndex.h"
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerObjectIndex.h"
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerMuonMatcher.h"
 
 //For Trigger
 #include "FWCore/Common/interface/TriggerNames.h"
@@ -42,6 +52,8 @@
 #include "DataFormats/HLTReco/interface/TriggerEvent.h"
 #include "L1Trigger/L1TGlobal/interface/L1TGlobalUtil.h"
 #include "DataFormats/L1TGlobal/interface/GlobalAlgBlk.h"
+#include "CondFormats/L1TObjects/interface/L1TUtmTriggerMenu.h"
+#include "CondFormats/DataRecord/interface/L1TUtmTriggerMenuRcd.h"
 #include "HLTrigger/HLTcore/interface/TriggerExpressionData.h"
 #include "HLTrigger/HLTcore/interface/TriggerExpressionEvaluator.h"
 #include "HLTrigger/HLTcore/interface/TriggerExpressionParser.h"
@@ -102,6 +114,29 @@ struct KalmanVertexFitResult{
   }
 };
 
+// MET columns of the tree, selected by the metColumns parameter
+enum METColumn {
+  rawMET         = 1,
+  type1MET       = 2,
+  jecMETShift    = 4,
+  jerMETShift    = 8,
+  unclMETShift   = 16
+};
+
+// Type-1 MET shifts, each stored as t1met<name>up and t1met<name>dn
+struct METShiftColumn {
+  const char*                name;
+  unsigned                   column;
+  pat::MET::METUncertainty   up, down;
+};
+
+const METShiftColumn metShiftColumns[] = {
+  {"jec", jecMETShift , pat::MET::METUncertainty::JetEnUp        , pat::MET::METUncertainty::JetEnDown        },
+  {"jer", jerMETShift , pat::MET::METUncertainty::JetResUp       , pat::MET::METUncertainty::JetResDown       },
+  {"unc", unclMETShift, pat::MET::METUncertainty::UnclusteredEnUp, pat::MET::METUncertainty::UnclusteredEnDown}
+};
+const size_t nMETShiftColumns = sizeof(metShiftColumns) / sizeof(metShiftColumns[0]);
+
 LorentzVector makeLorentzVectorFromPxPyPzM(double px, double py, double pz, double m){
   double p2 = px*px+py*py+pz*pz;
   return LorentzVector(px,py,pz,sqrt(p2+m*m));
@@ -136,11 +171,11 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
   // New members from MIT code
 
         bool isGoodMuon(const pat::Muon& muon);
-        KalmanVertexFitResult vertexWithKalmanFitter( std::vector<const reco::Track*> trks, std::vector<float> masses);
+        KalmanVertexFitResult vertexWithKalmanFitter(const std::vector<reco::TransientTrack>& transTrks, const std::vector<float>& masses);
         KalmanVertexFitResult vertexMuonsWithKalmanFitter(const pat::Muon& muon1, const pat::Muon& muon2);
+        KalmanVertexFitResult vertexMuonsWithKalmanFitter(const reco::TransientTrack& track1, const reco::TransientTrack& track2);
 
 
-        char getJetID(const pat::JetRef&);
         bool isMediumMuon(const pat::MuonRef&);
 
         const edm::InputTag triggerResultsTag;
@@ -160,7 +195,7 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         const edm::EDGetTokenT<std::vector<pat::MET> >                 metToken;
 
         const edm::EDGetTokenT<std::vector<PileupSummaryInfo> >        pileupInfoToken;
-        const edm::EDGetTokenT<std::vector<reco::GenParticle> >        gensToken;
+        GenParticleSummaryBuilder                                      genSummaryBuilder;
         const edm::EDGetTokenT<GenEventInfoProduct>                    genEvtInfoToken;
 
     //  const edm::EDGetTokenT<edm::ValueMap<bool> >                   electronVetoIdMapToken;
@@ -178,7 +213,8 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         // - isMC           : Is this a MC sample ?
         // - useLHEWeights  : If this is an MC sample, should we read the LHE level event weights
         // - useMedium2016  : Use medium muon ID tuned for the HIP affected data
-        bool                         applyHLTFilter, applyDimuonFilter, isMC, useLHEWeights, useMediumID2016, addEventInfo, filterHToMuMu;		 
+        // - dumpL1Table    : Walk the full L1 menu decision table every event (for debugging only)
+        bool                         applyHLTFilter, applyDimuonFilter, isMC, useLHEWeights, useMediumID2016, addEventInfo, filterHToMuMu, dumpL1Table;		 
 
         // Event coordinates
         unsigned                     event, run, lumSec;
@@ -211,8 +247,14 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         std::vector<bool>            midmedium;
         std::vector<bool>            midtight;
         std::vector<double>          miso;
-
-        // Collection of dimuon 4-vectors, dimuon mass errors, and indices of the muon daughters in the muon vectors, 
+        // Transverse impact parameter of the muon track, as m1Impact and m2Impact (-999 if the muon has no track)
+        std::vector<double>          mdxy;
+        // HLT paths matched by each muon, bit i standing for hltMatchPaths[i] (only stored if hltMatchPaths is not empty)
+        std::vector<unsigned>        mhlt;
+
+        // Dimuon mass errors, and indices of the muon daughters in the muon vectors
+        // These, and the pair vertex fit results below, are stored for all the pairs of muons in the
+        // triangular layout of PairIndex.h : the pair (i, j) is at slot pairSlot(i, j)
         std::vector<unsigned char>   m1idx;
         std::vector<unsigned char>   m2idx;
         std::vector<double>          masserr;
@@ -222,7 +264,13 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         //std::vector<char>            eid;
 
         // Raw and Type-1 MET
-        double                       met, metphi, t1met, t1metphi, t1metjecup, t1metjecupphi, t1metjecdn, t1metjecdnphi, t1metjerup, t1metjerupphi, t1metjerdn, t1metjerdnphi, t1metuncup, t1metuncupphi, t1metuncdn, t1metuncdnphi;
+        double                       met, metphi, t1met, t1metphi;
+
+        // Type-1 MET shifted up (2k) and down (2k+1) by the uncertainty k of metShiftColumns
+        struct METShift {
+            float pt, phi;
+        };
+        METShift                     t1metShifts[2*nMETShiftColumns];
 
         // Collection of jet 4-vectors, jet ID bytes and b-tag discriminant values
         std::vector<TLorentzVector>  jets;
@@ -236,6 +284,13 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         std::vector<double>          lxyErr;
         std::vector<double>          sigLxy;
         std::vector<double>          chiSq; 
+
+        // Vertex fit results of each pair of muons (-1 if the pair was not fitted, or the fit failed)
+        std::vector<double>          pairVtxProb;
+        std::vector<double>          pairLxy;
+        std::vector<double>          pairLxyErr;
+        std::vector<double>          pairSigLxy;
+        std::vector<double>          pairChiSq;
   
         std::vector<double>          m1Impact;
         std::vector<double>          m2Impact;
@@ -247,6 +302,31 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         // TTree carrying the event weight information
         TTree* tree;
 
+        // Scratch buffers reused from one event to the next
+        std::vector<pat::MuonRef>    muonv;
+        std::vector<pat::JetRef>     jetv;
+        JetSummary                   jetSummary;
+        CompositeCandMassResolution  merr;
+
+        // Heap allocations made per event
+        AllocationMonitor            allocMonitor;
+
+        // Pairs of good muons that are given to the vertex fit
+        DimuonPairSelector               pairSelector;
+        std::vector<unsigned>            goodMuonIdx;
+        std::vector<DimuonPairCandidate> muonPairs;
+
+        // Transient tracks of the good muons, built once per event (same indexing as muonv)
+        std::vector<reco::TransientTrack> muonTracks;
+
+        // Largest distance of closest approach (cm) between the two muon tracks for a pair to be fitted (negative to disable)
+        double                       maxPairDCA;
+
+        // Number of good muon pairs and of vertex fits performed, per event and over the job
+        // Over the job we also count the pairs dropped by the preselection and by the DCA requirement
+        unsigned                     npairs, nfits;
+        unsigned long long           totalPairs, totalPreselRejected, totalDCARejected, totalFits;
+
         // Sorters to order object collections in decreasing order of pT
         template<typename T> 
         class PatPtSorter {
@@ -268,8 +348,15 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         edm::InputTag                extInputTag_;       
         edm::EDGetToken              algToken_;
         edm::EDGetToken              extToken_;
-        l1t::L1TGlobalUtil          *l1GtUtils_;
-        std::vector<bool> l1Result_;
+        std::unique_ptr<l1t::L1TGlobalUtil> l1GtUtils_;
+
+        // Bit index in the GlobalAlgBlk of each configured L1 seed (-1 if the seed is not in the menu)
+        // These are resolved again only when the L1 menu changes
+        unsigned long long           l1MenuCacheId_;
+        std::vector<int>             l1SeedBits_;
+
+        // Final decision of each L1 seed, bit i corresponding to l1Seeds_[i]
+        ULong64_t                    l1Bits_;
         
         float MuonMass_    = 0.10565837;
         edm::ESHandle<TransientTrackBuilder> theTTBuilder_;
@@ -278,6 +365,24 @@ class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::on
         edm::EDGetTokenT<reco::BeamSpot> beamSpotToken_;
         const reco::BeamSpot* beamSpot_;       
 
+        // Debug printout of the dimuon vertex search
+        DebugTrace                   trace;
+
+        // HLT matching of the muons
+        // - hltMatchPaths       : paths (names without the version, e.g. HLT_IsoMu24) whose trigger objects are matched to the muons, empty to disable
+        // - hltMatchCollections : collections of the trigger objects to match, empty for all of them
+        // The matching criteria are the parameters of TriggerMuonMatcher
+        std::vector<std::string>     hltMatchPaths;
+        TriggerObjectIndex           hltMatchIndex;
+        TriggerMuonMatcher           muonMatcher;
+
+        // MET columns stored in the tree (OR of METColumn), the MET is not read if there are none
+        // - raw         : met, metphi
+        // - type1       : t1met, t1metphi (needed by the skim)
+        // - jec, jer, unclustered : type-1 MET shifted up and down by these uncertainties, each shift
+        //                 computed once and stored as a (pt, phi) pair of floats
+        unsigned                     metColumns;
+
   //        edm::EDGetTokenT<edm::TriggerResults> triggerResultsToken;
         
  
@@ -298,7 +403,7 @@ TreeMaker::TreeMaker(const edm::ParameterSet& iConfig):
     jetsToken                (consumes<std::vector<pat::Jet> >                 (iConfig.getParameter<edm::InputTag>("jets"))),
     metToken                 (consumes<std::vector<pat::MET> >                 (iConfig.getParameter<edm::InputTag>("met"))),
     pileupInfoToken          (consumes<std::vector<PileupSummaryInfo> >        (iConfig.getParameter<edm::InputTag>("pileupinfo"))),
-    gensToken                (consumes<std::vector<reco::GenParticle> >        (iConfig.getParameter<edm::InputTag>("gens"))),
+    genSummaryBuilder        (iConfig, consumesCollector(), {13}),
     genEvtInfoToken          (consumes<GenEventInfoProduct>                    (iConfig.getParameter<edm::InputTag>("geneventinfo"))),
 //  electronVetoIdMapToken   (consumes<edm::ValueMap<bool> >                   (iConfig.getParameter<edm::InputTag>("electronidveto"))),
 //  electronLooseIdMapToken  (consumes<edm::ValueMap<bool> >                   (iConfig.getParameter<edm::InputTag>("electronidloose"))),
@@ -311,19 +416,45 @@ TreeMaker::TreeMaker(const edm::ParameterSet& iConfig):
     useMediumID2016          (iConfig.existsAs<bool>("useMediumID2016")   ? iConfig.getParameter<bool>  ("useMediumID2016")   : false),
     addEventInfo             (iConfig.existsAs<bool>("addEventInfo")      ? iConfig.getParameter<bool>  ("addEventInfo")      : false),
     filterHToMuMu            (iConfig.existsAs<bool>("filterHToMuMu")     ? iConfig.getParameter<bool>  ("filterHToMuMu")     : false),
+    dumpL1Table              (iConfig.existsAs<bool>("dumpL1Table")       ? iConfig.getParameter<bool>  ("dumpL1Table")       : false),
     xsec                     (iConfig.existsAs<double>("xsec")            ? iConfig.getParameter<double>("xsec") * 1000.0     : 1.),
+    jetSummary               (iConfig.existsAs<std::string>("jetPileupIDDiscriminant") ? iConfig.getParameter<std::string>("jetPileupIDDiscriminant") : "pileupJetId:fullDiscriminant",
+                              iConfig.existsAs<std::string>("jetBTagDiscriminant")     ? iConfig.getParameter<std::string>("jetBTagDiscriminant")     : "pfCombinedInclusiveSecondaryVertexV2BJetTags"),
+    pairSelector             (iConfig),
+    maxPairDCA               (iConfig.existsAs<double>("maxPairDCA")      ? iConfig.getParameter<double>("maxPairDCA")        : -1.),
+    totalPairs               (0),
+    totalPreselRejected      (0),
+    totalDCARejected         (0),
+    totalFits                (0),
     l1Seeds_                 (iConfig.getParameter<std::vector<std::string> >("l1Seeds")),
     algInputTag_             (iConfig.getParameter<InputTag>("AlgInputTag")),
     extInputTag_             (iConfig.getParameter<InputTag>("ExtInputTag")),
     algToken_                (consumes<BXVector<GlobalAlgBlk> >(algInputTag_)),
     extToken_                (consumes<BXVector<GlobalExtBlk> >(extInputTag_)),
+    l1MenuCacheId_           (0),
     beamSpotToken_( consumes<reco::BeamSpot> ( iConfig.getParameter<edm::InputTag>( "beamSpot" ) ) ),
-    beamSpot_(nullptr)
+    beamSpot_(nullptr),
+    trace(iConfig),
+    hltMatchPaths            (iConfig.existsAs<std::vector<std::string> >("hltMatchPaths")       ? iConfig.getParameter<std::vector<std::string> >("hltMatchPaths")       : std::vector<std::string>()),
+    hltMatchIndex            (iConfig.existsAs<std::vector<std::string> >("hltMatchCollections") ? iConfig.getParameter<std::vector<std::string> >("hltMatchCollections") : std::vector<std::string>(), hltMatchPaths),
+    muonMatcher              (iConfig),
+    metColumns               (0)
 
 
 {
 	usesResource("TFileService");
-    l1GtUtils_  = new L1TGlobalUtil(iConfig, consumesCollector(), *this, algInputTag_, extInputTag_);
+    if (l1Seeds_.size() > 64) throw cms::Exception("Configuration") << "At most 64 L1 seeds can be stored in the l1Bits branch, " << l1Seeds_.size() << " were given";
+    if (dumpL1Table) l1GtUtils_.reset(new L1TGlobalUtil(iConfig, consumesCollector(), *this, algInputTag_, extInputTag_));
+
+    std::vector<std::string> metColumnNames = iConfig.existsAs<std::vector<std::string> >("metColumns") ? iConfig.getParameter<std::vector<std::string> >("metColumns") : std::vector<std::string>();
+    for (const std::string& name : metColumnNames) {
+        if      (name == "raw"        ) metColumns |= rawMET;
+        else if (name == "type1"      ) metColumns |= type1MET;
+        else if (name == "jec"        ) metColumns |= jecMETShift;
+        else if (name == "jer"        ) metColumns |= jerMETShift;
+        else if (name == "unclustered") metColumns |= unclMETShift;
+        else throw cms::Exception("Configuration") << "Unknown MET column " << name << ", expected raw, type1, jec, jer or unclustered";
+    }
 }
 
 
@@ -331,6 +462,9 @@ TreeMaker::~TreeMaker() {
 }
 
 void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+    AllocationMonitor::Sentry allocSentry(allocMonitor);
+    trace.nextEvent();
+
     //cout << "1st test point" << endl;
     iSetup.get<IdealMagneticFieldRecord>().get(bFieldHandle_);
     //cout << "2nd test point" << endl;
@@ -369,7 +503,7 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     iEvent.getByToken(jetsToken, jetsH);
     
     Handle<vector<pat::MET> > metH;
-    iEvent.getByToken(metToken, metH);
+    if (metColumns != 0) iEvent.getByToken(metToken, metH);
 
     /*
     Handle<vector<pat::Electron> > electronsH;
@@ -393,15 +527,10 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     
     Handle<GenEventInfoProduct> genEvtInfoH;
     if (isMC && useLHEWeights) iEvent.getByToken(genEvtInfoToken, genEvtInfoH);
-    
-    Handle<vector<GenParticle> > gensH;
-    if (isMC) iEvent.getByToken(gensToken, gensH);
 
 
     // new trigger collection
-    edm::Handle<edm::TriggerResults> trigger;
-    iEvent.getByToken(triggerResultsToken,trigger);
-    const edm::TriggerNames trigNames = iEvent.triggerNames(*trigger);
+    const edm::TriggerNames& trigNames = iEvent.triggerNames(*triggerResultsH);
 
 
     Handle<BXVector<GlobalAlgBlk>> alg;
@@ -410,54 +539,39 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     Handle<BXVector<GlobalExtBlk>> ext;
     iEvent.getByToken(extToken_,ext);
 
-    l1GtUtils_->retrieveL1(iEvent,iSetup,algToken_);
-
-    const std::vector<std::pair<std::string, bool> > initialDecisions = l1GtUtils_->decisionsInitial();
-    const std::vector<std::pair<std::string, bool> > intermDecisions = l1GtUtils_->decisionsInterm();
-    const std::vector<std::pair<std::string, bool> > finalDecisions = l1GtUtils_->decisionsFinal();
-    const std::vector<std::pair<std::string, int> >  prescales = l1GtUtils_->prescales();
-    const std::vector<std::pair<std::string, std::vector<int>> > masks = l1GtUtils_->masks();
-
-    //cout << "\n===================================== Trigger Results for BX=0 =============================================\n" << endl;
-    //cout << "    Bit                  Algorithm Name                  Init    aBXM  Final   PS Factor     Num Bx Masked" << endl;
-    //cout << "============================================================================================================" << endl;
-
-    for(unsigned int i=0; i<initialDecisions.size(); i++) {
-        
-      // get the name and trigger result
-      std::string name = (initialDecisions.at(i)).first;
-      if(name == "NULL") continue;
-
-      //bool found = false;
-      //for( unsigned int iseed = 0; iseed < l1Seeds_.size(); iseed++ ) {
-      //    if (name == string(l1Seeds_[iseed])) found = true;
-      //}  
-      //if (!found) continue;
-
-      bool resultInit = (initialDecisions.at(i)).second;
-
-      // get prescaled and final results (need some error checking here)
-      bool resultInterm = (intermDecisions.at(i)).second;
-      bool resultFin = (finalDecisions.at(i)).second;
-
-      // get the prescale and mask (needs some error checking here)
-      int prescale = (prescales.at(i)).second;
-      std::vector<int> mask    = (masks.at(i)).second;
-
-      //cout << std::dec << setfill(' ') << "   " << setw(5) << i << "   " << setw(40) << name.c_str() << "   " << setw(7) << resultInit << setw(7) << resultInterm << setw(7) << resultFin << setw(10) << prescale << setw(11) << mask.size() << endl;
+    // The full L1 decision table is only walked on request, the seeds we store are read below
+    if (dumpL1Table) {
+        l1GtUtils_->retrieveL1(iEvent,iSetup,algToken_);
+
+        const std::vector<std::pair<std::string, bool> >& initialDecisions = l1GtUtils_->decisionsInitial();
+        const std::vector<std::pair<std::string, bool> >& intermDecisions  = l1GtUtils_->decisionsInterm();
+        const std::vector<std::pair<std::string, bool> >& finalDecisions   = l1GtUtils_->decisionsFinal();
+        const std::vector<std::pair<std::string, int> >&  prescales        = l1GtUtils_->prescales();
+        const std::vector<std::pair<std::string, std::vector<int> > >& masks = l1GtUtils_->masks();
+
+        edm::LogVerbatim dump("L1TableDump");
+        dump << "    Bit                  Algorithm Name                  Init    aBXM  Final   PS Factor     Num Bx Masked\n";
+        for (unsigned int i = 0; i < initialDecisions.size(); i++) {
+            const std::string& name = initialDecisions[i].first;
+            if (name == "NULL") continue;
+            dump << std::setw(7) << i << "   " << std::setw(40) << name << "   " 
+                 << std::setw(7) << initialDecisions[i].second << std::setw(7) << intermDecisions[i].second << std::setw(7) << finalDecisions[i].second 
+                 << std::setw(10) << prescales[i].second << std::setw(11) << masks[i].second.size() << "\n";
+        }
     }
 
-    l1Result_.clear();
-    for( unsigned int iseed = 0; iseed < l1Seeds_.size(); iseed++ ) {
-        bool l1htbit = 0;
-        l1GtUtils_->getFinalDecisionByName(string(l1Seeds_[iseed]), l1htbit);
-        //cout<<string(l1Seeds_[iseed])<<" "<<l1htbit<<endl;
-        l1Result_.push_back( l1htbit );
+    // L1 seeds, read straight from the bit array of the central BX
+    l1Bits_ = 0;
+    if (alg.isValid() && !alg->isEmpty(0)) {
+        const GlobalAlgBlk& algBlk = alg->at(0, 0);
+        for (size_t iseed = 0; iseed < l1SeedBits_.size(); iseed++) {
+            if (l1SeedBits_[iseed] >= 0 && algBlk.getAlgoDecisionFinal(l1SeedBits_[iseed])) l1Bits_ |= (ULong64_t(1) << iseed);
+        }
     }
 
     
     m1idx.clear()    ; m2idx.clear(); masserr.clear();
-    muons    .clear(); mid.clear(); miso.clear();
+    muons    .clear(); mid.clear(); miso.clear(); mdxy.clear(); mhlt.clear();
     //electrons.clear(); eid.clear();
     jets     .clear(); jid.clear(); jbtag.clear();
     gens     .clear(); gid.clear(); gvtx.clear();
@@ -473,10 +587,15 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     sigLxy.clear();
     chiSq.clear();
 
+    pairVtxProb.clear();
+    pairLxy    .clear();
+    pairLxyErr .clear();
+    pairSigLxy .clear();
+    pairChiSq  .clear();
+
     m1Impact.clear();
     m2Impact.clear();
     
-    triggersPassed.clear();
     fullList.clear();
 
 
@@ -490,10 +609,11 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 
 
 
-    unsigned int _tSize = trigger->size();
+    unsigned int _tSize = triggerResultsH->size();
     // create a string with all passing trigger names
     for (unsigned int i=0; i<_tSize; ++i) {
-      std::string triggerName = trigNames.triggerName(i);
+      if (!triggerResultsH->accept(i)) continue;
+      const std::string& triggerName = trigNames.triggerName(i);
       if (strstr(triggerName.c_str(),"_step")) continue;
       if (strstr(triggerName.c_str(),"MC_")) continue;
       if (strstr(triggerName.c_str(),"AlCa_")) continue;
@@ -507,9 +627,11 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
       if (strstr(triggerName.c_str(),"Ecal")) continue;
       if (!strstr(triggerName.c_str(),"mu")&&!strstr(triggerName.c_str(),"Mu")) continue;
       //cout << triggerName;
-      if (trigger->accept(i)) fullList += triggerName;
+      fullList += triggerName;
     }
-    triggersPassed.push_back(fullList);
+    // Assigning into the existing element keeps its capacity from one event to the next
+    triggersPassed.resize(1);
+    triggersPassed[0] = fullList;
 
     // Trigger info
     hltsinglemu = 0;
@@ -570,7 +692,7 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 
 
     // Muon information
-    vector<pat::MuonRef> muonv;
+    muonv.clear();
     for (auto muons_iter = muonsH->begin(); muons_iter != muonsH->end(); ++muons_iter) {
         if (muons_iter->pt() < 4.0) continue;
         if (fabs(muons_iter->eta()) > 1.9) continue;
@@ -595,36 +717,66 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 
 
     // Vertex Calculation (Take best p-value pair)
-    float bestP = 1;
+    // The pairs of good muons go through the following stages, the later ones only seeing the survivors of the earlier ones
+    // - Charge, deltaR, mass preselection and cap on the number of pairs, see DimuonPairSelector
+    // - Distance of closest approach between the two tracks
+    // - Kalman vertex fit
+    goodMuonIdx.clear();
+    muonTracks.resize(muonv.size());
+    for (unsigned int i = 0; i < muonv.size(); i++) {
+        if (not isGoodMuon(*muonv[i].get())) continue;
+        goodMuonIdx.push_back(i);
+        muonTracks[i] = (*theTTBuilder_).build(muonv[i]->innerTrack().get());
+    }
+    pairSelector.select(muonv, goodMuonIdx, muonPairs);
+    npairs = pairSelector.nConsidered();
+    nfits  = 0;
+    totalPreselRejected += pairSelector.nConsidered() - pairSelector.nSelected();
+
+    float bestP = -1;
     float bestLxy = 0;
     float bestLxyErr = 0;
     float bestSigLxy = 0;
     bool bestValid = 0;
-    vector<int> bestMu = {0,0};
-    cout << "iter. start" << endl;
-    for (unsigned int i = 0; i<(sizeof(muonv)-1); i++){
-      cout << i << endl;
-      if (not isGoodMuon(*muonv[i].get())) continue;
-      for (unsigned int j = i+1; j<sizeof(muonv); j++){
-	cout << j <<endl;
-	if (not isGoodMuon(*muonv[j].get())) continue;
-	auto kalmanMuMuVertexFit = vertexMuonsWithKalmanFitter(*muonv[i].get(), *muonv[j].get());
-	kalmanMuMuVertexFit.postprocess(*beamSpot_);
-        cout << "new pair, mu " << i << "mu " << j << endl; 
-	//cout << "Lxy of leading dimuon pair = " << kalmanMuMuVertexFit.lxy << endl;
-	if (kalmanMuMuVertexFit.vtxProb < bestP){
-	  bestP = kalmanMuMuVertexFit.vtxProb;
-	  cout << "new best P value: " << bestP << endl;
-	  bestSigLxy = kalmanMuMuVertexFit.sigLxy;
-	  bestLxyErr = kalmanMuMuVertexFit.lxyErr;
-	  bestLxy = kalmanMuMuVertexFit.lxy;
-	  bestValid = kalmanMuMuVertexFit.valid;
-	  bestMu[0] = i;
-	  bestMu[1] = j;
-	}
+    unsigned int bestMu[2] = {0,0};
+    DILEPTON_TRACE(trace, "TreeMakerVertex") << "Run " << iEvent.id().run() << " event " << iEvent.id().event() << " : " << goodMuonIdx.size() << " good muons, " << muonPairs.size() << " pairs to fit";
+    pairVtxProb.assign(nPairSlots(muonv.size()), -1.);
+    pairLxy    .assign(nPairSlots(muonv.size()), -1.);
+    pairLxyErr .assign(nPairSlots(muonv.size()), -1.);
+    pairSigLxy .assign(nPairSlots(muonv.size()), -1.);
+    pairChiSq  .assign(nPairSlots(muonv.size()), -1.);
+    TwoTrackMinimumDistance ttmd;
+    for (const DimuonPairCandidate& pair : muonPairs) {
+      if (maxPairDCA >= 0. && ttmd.calculate(muonTracks[pair.first].initialFreeState(), muonTracks[pair.second].initialFreeState()) && ttmd.distance() > maxPairDCA) {
+        DILEPTON_TRACE(trace, "TreeMakerVertex") << "pair (" << pair.first << ", " << pair.second << ") : DCA = " << ttmd.distance() << ", not fitted";
+        totalDCARejected++;
+        continue;
+      }
+      auto kalmanMuMuVertexFit = vertexMuonsWithKalmanFitter(muonTracks[pair.first], muonTracks[pair.second]);
+      kalmanMuMuVertexFit.postprocess(*beamSpot_);
+      nfits++;
+      DILEPTON_TRACE(trace, "TreeMakerVertex") << "pair (" << pair.first << ", " << pair.second << ") : vtxProb = " << kalmanMuMuVertexFit.vtxProb << ", lxy = " << kalmanMuMuVertexFit.lxy;
+      if (not kalmanMuMuVertexFit.valid) continue;
+      size_t slot = pairSlot(pair.first, pair.second);
+      pairVtxProb[slot] = kalmanMuMuVertexFit.vtxProb;
+      pairLxy    [slot] = kalmanMuMuVertexFit.lxy;
+      pairLxyErr [slot] = kalmanMuMuVertexFit.lxyErr;
+      pairSigLxy [slot] = kalmanMuMuVertexFit.sigLxy;
+      pairChiSq  [slot] = kalmanMuMuVertexFit.chiSq;
+      if (kalmanMuMuVertexFit.vtxProb > bestP){
+        bestP = kalmanMuMuVertexFit.vtxProb;
+        DILEPTON_TRACE(trace, "TreeMakerVertex") << "new best vtxProb : " << bestP;
+        bestSigLxy = kalmanMuMuVertexFit.sigLxy;
+        bestLxyErr = kalmanMuMuVertexFit.lxyErr;
+        bestLxy = kalmanMuMuVertexFit.lxy;
+        bestValid = kalmanMuMuVertexFit.valid;
+        bestMu[0] = pair.first;
+        bestMu[1] = pair.second;
       }
     }
-    if (bestMu[0] == 0 && bestMu[1] == 0) return;
+    totalPairs += npairs;
+    totalFits  += nfits;
+    if (not bestValid) return;
     vtxProb.push_back(bestP);
     valid.push_back(bestValid);
     lxy.push_back(bestLxy);
@@ -641,7 +793,14 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     */
     m1Impact.push_back(muonv[bestMu[0]]->track().get()->dxy());
     m2Impact.push_back(muonv[bestMu[1]]->track().get()->dxy());
-    cout << "passed muons" << endl;
+    DILEPTON_TRACE(trace, "TreeMakerVertex") << "selected pair (" << bestMu[0] << ", " << bestMu[1] << ")";
+
+    // HLT matching of the muons
+    if (not hltMatchPaths.empty()) {
+        hltMatchIndex.fill(*triggerObjectsH, trigNames);
+        muonMatcher.setOfflineMuons(muonv, verticesH->at(0));
+        muonMatcher.match(hltMatchIndex);
+    }
 
     int nLoose=0;
     for (size_t i = 0; i < muonv.size(); i++) {
@@ -656,6 +815,9 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
         muonisoval /= muonv[i]->pt();
         miso.push_back(muonisoval);
 
+        mdxy.push_back(muonv[i]->track().isNonnull() ? muonv[i]->track()->dxy() : -999.);
+        if (not hltMatchPaths.empty()) mhlt.push_back(muonMatcher.matchedPathBits(i));
+
         // Muon ID
         if (muonv[i]->isLooseMuon()) nLoose+=1;
 
@@ -700,8 +862,10 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
         if (applyDimuonFilter) return;
     }
 
-    for (size_t i = 0; i < muonv.size(); i++) {
-        for (size_t j = i+1; j < muonv.size(); j++) {
+    // Pairs in the order of PairIndex.h
+    merr.init(iSetup);
+    for (size_t j = 1; j < muonv.size(); j++) {
+        for (size_t i = 0; i < j; i++) {
             
             CompositeCandidate mm("mm");
             mm.addDaughter(ShallowCloneCandidate(CandidateBaseRef(muonv[i])), "muon1");
@@ -711,8 +875,6 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
             
             double masserrval = -1.;    
             if (muonv[i]->track().isNonnull() && muonv[j]->track().isNonnull()) {       
-                CompositeCandMassResolution merr;
-                merr.init(iSetup);
                 masserrval = merr.getMassResolution(mm);
             }
             masserr.push_back(masserrval);
@@ -770,7 +932,7 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     */
 
     // Jets information
-    vector<pat::JetRef> jetv;
+    jetv.clear();
     for (auto jets_iter = jetsH->begin(); jets_iter != jetsH->end(); ++jets_iter) {
         pat::JetRef jref(jetsH, jets_iter - jetsH->begin());
         if (jref->pt() < 20.0) continue;
@@ -779,49 +941,50 @@ void TreeMaker::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     }
     if (jetv.size() > 0) sort(jetv.begin(), jetv.end(), jetSorter);
 
+    jetSummary.fill(jetv);
     for (size_t i = 0; i < jetv.size(); i++) {
         TLorentzVector j4;
         j4.SetPtEtaPhiM(jetv[i]->pt(), jetv[i]->eta(), jetv[i]->phi(), jetv[i]->mass());
         jets.push_back(j4);
-        double btv = -10.0;
-        if (fabs(jetv[i]->eta()) < 2.4) btv = jetv[i]->bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
-        jbtag.push_back(btv);
-        jid  .push_back(getJetID(jetv[i]));
+        jbtag.push_back(jetSummary.bTag(i));
+        jid  .push_back(jetSummary.id(i));
+    }
+
+    // MET information, only for the columns stored in the tree
+    if (metColumns != 0) {
+        const pat::MET& patMET = metH->front();
+        if (metColumns & rawMET) {
+            met      = patMET.uncorPt();
+            metphi   = patMET.uncorPhi();
+        }
+        if (metColumns & type1MET) {
+            t1met    = patMET.et();
+            t1metphi = patMET.phi();
+        }
+        for (size_t k = 0; k < nMETShiftColumns; k++) {
+            if (not (metColumns & metShiftColumns[k].column)) continue;
+            pat::MET::Vector2 up   = patMET.shiftedP2(metShiftColumns[k].up  );
+            pat::MET::Vector2 down = patMET.shiftedP2(metShiftColumns[k].down);
+            t1metShifts[2*k  ].pt  = up  .pt();
+            t1metShifts[2*k  ].phi = up  .phi();
+            t1metShifts[2*k+1].pt  = down.pt();
+            t1metShifts[2*k+1].phi = down.phi();
+        }
     }
 
-    // MET information
-    met           = metH->front().uncorPt();
-    metphi        = metH->front().uncorPhi();
-    t1met         = metH->front().et();
-    t1metphi      = metH->front().phi();
-    t1metjecup    = metH->front().shiftedP2(pat::MET::METUncertainty::JetEnUp          ).pt();
-    t1metjecupphi = metH->front().shiftedP2(pat::MET::METUncertainty::JetEnUp          ).phi();
-    t1metjecdn    = metH->front().shiftedP2(pat::MET::METUncertainty::JetEnDown        ).pt();
-    t1metjecdnphi = metH->front().shiftedP2(pat::MET::METUncertainty::JetEnDown        ).phi();
-    t1metjerup    = metH->front().shiftedP2(pat::MET::METUncertainty::JetResUp         ).pt();
-    t1metjerupphi = metH->front().shiftedP2(pat::MET::METUncertainty::JetResUp         ).phi();
-    t1metjerdn    = metH->front().shiftedP2(pat::MET::METUncertainty::JetResDown       ).pt();
-    t1metjerdnphi = metH->front().shiftedP2(pat::MET::METUncertainty::JetResDown       ).phi();
-    t1metuncup    = metH->front().shiftedP2(pat::MET::METUncertainty::UnclusteredEnUp  ).pt();
-    t1metuncupphi = metH->front().shiftedP2(pat::MET::METUncertainty::UnclusteredEnUp  ).phi();
-    t1metuncdn    = metH->front().shiftedP2(pat::MET::METUncertainty::UnclusteredEnDown).pt();
-    t1metuncdnphi = metH->front().shiftedP2(pat::MET::METUncertainty::UnclusteredEnDown).phi();
-
-
-    // GEN information
-    if (isMC && gensH.isValid()) {
-
-        for (auto gens_iter = gensH->begin(); gens_iter != gensH->end(); ++gens_iter) { 
-            if (abs(gens_iter->pdgId()) > 0.0 && abs(gens_iter->pdgId())==13 && gens_iter->fromHardProcessFinalState()) {
+
+    // GEN information, only for the events kept
+    const GenParticleSummary* genSummaryP = isMC ? genSummaryBuilder.get(iEvent) : nullptr;
+    if (genSummaryP != nullptr) {
+        const GenParticleSummary& genSummary = *genSummaryP;
+        for (size_t i = 0; i < genSummary.size(); i++) {
+            if (abs(genSummary.pdgId[i]) == 13 && genSummary.hasFlag(i, GenParticleSummary::fromHardProcessFinalState)) {
                 TLorentzVector g4;
-                g4.SetPtEtaPhiM(gens_iter->pt(), gens_iter->eta(), gens_iter->phi(), gens_iter->mass());
+                g4.SetPtEtaPhiM(genSummary.pt[i], genSummary.eta[i], genSummary.phi[i], genSummary.mass[i]);
                 gens.push_back(g4);
-                gid.push_back(char(gens_iter->pdgId()));
-		double y = gens_iter->vy();
-		double x = gens_iter->vx();
-		gvtx.push_back(sqrt(pow(x,2) + pow(y,2)));
+                gid.push_back(char(genSummary.pdgId[i]));
+                gvtx.push_back(genSummary.vrho[i]);
             }
-
         }
     }
 
@@ -853,7 +1016,7 @@ void TreeMaker::beginJob() {
     tree->Branch("hltdoublemu"          , &hltdoublemu                   , "hltdoublemu/b");
     tree->Branch("hltsingleel"          , &hltsingleel                   , "hltsingleel/b");
     tree->Branch("hltdoubleel"          , &hltdoubleel                   , "hltdoubleel/b");
-    tree->Branch("l1Result", "std::vector<bool>" ,&l1Result_ , 32000, 0); 
+    tree->Branch("l1Bits"               , &l1Bits_                       , "l1Bits/l");
     tree->Branch("trig"                , &trig                         , "trig/i");
 
     tree->Branch("triggersPassed"              , "std::vector<string>"          , &triggersPassed);
@@ -873,6 +1036,9 @@ void TreeMaker::beginJob() {
     tree->Branch("midmedium"                  , "std::vector<bool>"            , &midmedium      );
     tree->Branch("midtight"                  , "std::vector<bool>"            , &midtight      );
     tree->Branch("miso"                 , "std::vector<double>"          , &miso     );
+    tree->Branch("mdxy"                 , "std::vector<double>"          , &mdxy     );
+    if (not hltMatchPaths.empty())
+    tree->Branch("mhlt"                 , "std::vector<unsigned>"        , &mhlt     );
     tree->Branch("m1Impact"                 , "std::vector<double>"          , &m1Impact     );
     tree->Branch("m2Impact"                 , "std::vector<double>"          , &m2Impact     );
 
@@ -891,30 +1057,32 @@ void TreeMaker::beginJob() {
     tree->Branch("lxyErr"                     , "std::vector<double>"          , &lxyErr      );
     tree->Branch("sigLxy"                     , "std::vector<double>"          , &sigLxy      );
     tree->Branch("chiSq"                     , "std::vector<double>"          , &chiSq      );
+    tree->Branch("pairVtxProb"          , "std::vector<double>"          , &pairVtxProb);
+    tree->Branch("pairLxy"              , "std::vector<double>"          , &pairLxy    );
+    tree->Branch("pairLxyErr"           , "std::vector<double>"          , &pairLxyErr );
+    tree->Branch("pairSigLxy"           , "std::vector<double>"          , &pairSigLxy );
+    tree->Branch("pairChiSq"            , "std::vector<double>"          , &pairChiSq  );
+    tree->Branch("npairs"               , &npairs                        , "npairs/i");
+    tree->Branch("nfits"                , &nfits                         , "nfits/i");
 
     // Electron info
     //tree->Branch("electrons"            , "std::vector<TLorentzVector>"  , &electrons, 32000, 0);
     //tree->Branch("eid"                  , "std::vector<char>"            , &eid      );
 
-    // MET info
-    /*
-    tree->Branch("met"                  , &met                           , "met/D"          );
-    tree->Branch("metphi"               , &metphi                        , "metphi/D"       );
-    tree->Branch("t1met"                , &t1met                         , "t1met/D"        );
-    tree->Branch("t1metphi"             , &t1metphi                      , "t1metphi/D"     );
-    tree->Branch("t1metjecup"           , &t1metjecup                    , "t1metjecup/D"   );
-    tree->Branch("t1metjecupphi"        , &t1metjecupphi                 , "t1metjecupphi/D");
-    tree->Branch("t1metjecdn"           , &t1metjecdn                    , "t1metjecdn/D"   );
-    tree->Branch("t1metjecdnphi"        , &t1metjecdnphi                 , "t1metjecdnphi/D");
-    tree->Branch("t1metjerup"           , &t1metjerup                    , "t1metjerup/D"   );
-    tree->Branch("t1metjerupphi"        , &t1metjerupphi                 , "t1metjerupphi/D");
-    tree->Branch("t1metjerdn"           , &t1metjerdn                    , "t1metjerdn/D"   );
-    tree->Branch("t1metjerdnphi"        , &t1metjerdnphi                 , "t1metjerdnphi/D");
-    tree->Branch("t1metuncup"           , &t1metuncup                    , "t1metuncup/D"   );
-    tree->Branch("t1metuncupphi"        , &t1metuncupphi                 , "t1metuncupphi/D");
-    tree->Branch("t1metuncdn"           , &t1metuncdn                    , "t1metuncdn/D"   );
-    tree->Branch("t1metuncdnphi"        , &t1metuncdnphi                 , "t1metuncdnphi/D");
-    */
+    // MET info, the shifts as pairs of float leaves, e.g. t1metjecup.pt and t1metjecup.phi
+    if (metColumns & rawMET) {
+        tree->Branch("met"                  , &met                           , "met/D"          );
+        tree->Branch("metphi"               , &metphi                        , "metphi/D"       );
+    }
+    if (metColumns & type1MET) {
+        tree->Branch("t1met"                , &t1met                         , "t1met/D"        );
+        tree->Branch("t1metphi"             , &t1metphi                      , "t1metphi/D"     );
+    }
+    for (size_t k = 0; k < nMETShiftColumns; k++) {
+        if (not (metColumns & metShiftColumns[k].column)) continue;
+        tree->Branch((std::string("t1met") + metShiftColumns[k].name + "up").c_str(), &t1metShifts[2*k  ], "pt/F:phi/F");
+        tree->Branch((std::string("t1met") + metShiftColumns[k].name + "dn").c_str(), &t1metShifts[2*k+1], "pt/F:phi/F");
+    }
 
     // Jet info
     tree->Branch("jets"                 , "std::vector<TLorentzVector>"  , &jets     , 32000, 0);
@@ -928,9 +1096,31 @@ void TreeMaker::beginJob() {
 }
 
 void TreeMaker::endJob() {
+    allocMonitor.report("TreeMaker");
+    if (not hltMatchPaths.empty()) muonMatcher.report("TreeMaker");
+    edm::LogInfo("TreeMaker") << "Dimuon vertex search : " << totalPairs << " good muon pairs, " 
+                              << totalPreselRejected << " dropped by the preselection, " 
+                              << totalDCARejected << " dropped by the DCA requirement, " 
+                              << totalFits << " vertex fits performed";
 }
 
 void TreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup) {
+    // Map the L1 seed names to algorithm bits whenever the L1 menu changes
+    unsigned long long menuCacheId = iSetup.get<L1TUtmTriggerMenuRcd>().cacheIdentifier();
+    if (menuCacheId != l1MenuCacheId_) {
+        l1MenuCacheId_ = menuCacheId;
+
+        edm::ESHandle<L1TUtmTriggerMenu> menu;
+        iSetup.get<L1TUtmTriggerMenuRcd>().get(menu);
+
+        l1SeedBits_.assign(l1Seeds_.size(), -1);
+        for (size_t iseed = 0; iseed < l1Seeds_.size(); iseed++) {
+            auto algo = menu->getAlgorithmMap().find(l1Seeds_[iseed]);
+            if (algo != menu->getAlgorithmMap().end()) l1SeedBits_[iseed] = algo->second.getIndex();
+            else edm::LogWarning("TreeMaker") << "L1 seed " << l1Seeds_[iseed] << " is not in the L1 menu of run " << iRun.run();
+        }
+    }
+
     // HLT paths
     triggerPathsVector.push_back("DST_DoubleMu3_noVtx_CaloScouting_v*");
     /*
@@ -989,6 +1179,13 @@ void TreeMaker::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup) {
     }
 
     */
+
+    if (not hltMatchPaths.empty()) {
+        HLTConfigProvider hltMatchConfig;
+        bool changedMatchConfig = false;
+        hltMatchConfig.init(iRun, iSetup, triggerResultsTag.process(), changedMatchConfig);
+        hltMatchIndex.beginRun(hltMatchConfig.triggerNames());
+    }
 }
 
 void TreeMaker::endRun(edm::Run const&, edm::EventSetup const&) {
@@ -1000,41 +1197,6 @@ void TreeMaker::beginLuminosityBlock(edm::LuminosityBlock const& iLumi, edm::Eve
 void TreeMaker::endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) {
 }
 
-char TreeMaker::getJetID(const pat::JetRef& jet) {
-
-    char jetid  = 0;
-
-    double eta  = jet->eta();
-    double nhf  = jet->neutralHadronEnergyFraction();
-    double nemf = jet->neutralEmEnergyFraction();
-    double chf  = jet->chargedHadronEnergyFraction();
-    double muf  = jet->muonEnergyFraction();
-    double cemf = jet->muonEnergyFraction();
-    int    np   = jet->chargedMultiplicity() + jet->neutralMultiplicity();
-    int    nnp  = jet->neutralMultiplicity();
-    int    chm  = jet->chargedMultiplicity();
-
-    if ((nhf < 0.99 && nemf < 0.99 && np > 1             ) && ((fabs(eta) <= 2.4 && chf > 0 && chm > 0 && cemf < 0.99) || fabs(eta) > 2.4) && fabs(eta) <= 2.7) jetid += 1;
-    if ((nhf < 0.90 && nemf < 0.90 && np > 1             ) && ((fabs(eta) <= 2.4 && chf > 0 && chm > 0 && cemf < 0.99) || fabs(eta) > 2.4) && fabs(eta) <= 2.7) jetid += 2;
-    if ((nhf < 0.90 && nemf < 0.90 && np > 1 && muf < 0.8) && ((fabs(eta) <= 2.4 && chf > 0 && chm > 0 && cemf < 0.90) || fabs(eta) > 2.4) && fabs(eta) <= 2.7) jetid += 4;
-
-    if (nemf < 0.90 && nnp > 2 && fabs(eta) > 2.7 && fabs(eta) <= 3.0) jetid += 1;
-    if (nemf < 0.90 && nnp > 2 && fabs(eta) > 2.7 && fabs(eta) <= 3.0) jetid += 2;
-    if (nemf < 0.90 && nnp > 2 && fabs(eta) > 2.7 && fabs(eta) <= 3.0) jetid += 4;
-
-    if (nemf < 0.90 && nnp > 10 && fabs(eta) > 3.0) jetid += 1;
-    if (nemf < 0.90 && nnp > 10 && fabs(eta) > 3.0) jetid += 2;
-    if (nemf < 0.90 && nnp > 10 && fabs(eta) > 3.0) jetid += 4;
-
-    double puidval   = jet->userFloat("pileupJetId:fullDiscriminant");
-    if (fabs(eta) >= 0.00 && fabs(eta) < 2.50 && puidval > -0.63) jetid += 8;
-    if (fabs(eta) >= 2.50 && fabs(eta) < 2.75 && puidval > -0.60) jetid += 8;
-    if (fabs(eta) >= 2.75 && fabs(eta) < 3.00 && puidval > -0.55) jetid += 8;
-    if (fabs(eta) >= 3.00 && fabs(eta) < 5.00 && puidval > -0.45) jetid += 8;
-
-    return jetid;
-}
-
 bool TreeMaker::isMediumMuon(const pat::MuonRef& muon) {
       bool goodGlob = muon->isGlobalMuon() && 
                       muon->globalTrack()->normalizedChi2() < 3 && 
@@ -1052,15 +1214,11 @@ void TreeMaker::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
 	descriptions.addDefault(desc);
 }
 
-KalmanVertexFitResult TreeMaker::vertexWithKalmanFitter(std::vector<const reco::Track*> trks, 
-					 std::vector<float> masses){
-  if (trks.size()!=masses.size()) 
+KalmanVertexFitResult TreeMaker::vertexWithKalmanFitter(const std::vector<reco::TransientTrack>& transTrks, 
+					 const std::vector<float>& masses){
+  if (transTrks.size()!=masses.size()) 
     throw cms::Exception("Error") << "number of tracks and number of masses should match";
   KalmanVertexFitResult results;
-  std::vector<reco::TransientTrack> transTrks;
-  for (auto trk: trks){
-    transTrks.push_back((*theTTBuilder_).build(trk));
-  }
   KalmanVertexFitter kvf(true);
   TransientVertex tv = kvf.vertex(transTrks);
 
@@ -1084,12 +1242,12 @@ KalmanVertexFitResult TreeMaker::vertexWithKalmanFitter(std::vector<const reco::
 }
 
 KalmanVertexFitResult TreeMaker::vertexMuonsWithKalmanFitter(const pat::Muon& muon1, const pat::Muon& muon2) {
-  std::vector<const reco::Track*> trks;
-  std::vector<float> masses;
-  trks.push_back( muon1.innerTrack().get() );
-  masses.push_back(MuonMass_);
-  trks.push_back( muon2.innerTrack().get() );
-  masses.push_back(MuonMass_);
+  return vertexMuonsWithKalmanFitter((*theTTBuilder_).build(muon1.innerTrack().get()), (*theTTBuilder_).build(muon2.innerTrack().get()));
+}
+
+KalmanVertexFitResult TreeMaker::vertexMuonsWithKalmanFitter(const reco::TransientTrack& track1, const reco::TransientTrack& track2) {
+  std::vector<reco::TransientTrack> trks = {track1, track2};
+  std::vector<float> masses = {MuonMass_, MuonMass_};
   return vertexWithKalmanFitter(trks,masses);
 }
 
@@ -0,0 +1,8 @@
+import FWCore.ParameterSet.Config as cms
+
+# GEN particles used by the tree makers (TreeMaker, ScoutingTreeMaker, HLTMuonTreeMaker), extracted once per event
+genParticleSummary = cms.EDProducer("GenParticleSummaryProducer",
+    gens   = cms.InputTag("prunedGenParticles"),
+    # |PDG ID| of the particles to keep (leptons, W, Z, H and dark photon), all of them if empty
+    pdgIds = cms.vint32(11, 12, 13, 14, 15, 16, 23, 24, 25, 1023)
+)
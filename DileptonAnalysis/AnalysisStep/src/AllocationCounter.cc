@@ -0,0 +1,72 @@
+#include <cstdlib>
+#include <new>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/AllocationCounter.h"
+
+#ifdef DILEPTON_COUNT_ALLOCATIONS
+
+namespace {
+    thread_local unsigned long long nallocs = 0;
+
+    void* countedAlloc(std::size_t size) {
+        ++nallocs;
+        return std::malloc(size > 0 ? size : 1);
+    }
+}
+
+void* operator new(std::size_t size) {
+    void* ptr = countedAlloc(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    void* ptr = countedAlloc(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new  (std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete  (void* ptr) noexcept                        { std::free(ptr); }
+void operator delete[](void* ptr) noexcept                        { std::free(ptr); }
+void operator delete  (void* ptr, std::size_t) noexcept           { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept           { std::free(ptr); }
+void operator delete  (void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+bool AllocationCounter::enabled() {
+    return true;
+}
+
+unsigned long long AllocationCounter::allocations() {
+    return nallocs;
+}
+
+#else
+
+bool AllocationCounter::enabled() {
+    return false;
+}
+
+unsigned long long AllocationCounter::allocations() {
+    return 0;
+}
+
+#endif
+
+void AllocationMonitor::add(unsigned long long nallocs) {
+    nevents_++;
+    total_ += nallocs;
+    if (nallocs > max_) max_ = nallocs;
+}
+
+void AllocationMonitor::report(const std::string& label) const {
+    if (not AllocationCounter::enabled() || nevents_ == 0) return;
+    edm::LogInfo("AllocationMonitor") << label << " : " << nevents_ << " events, "
+                                      << double(total_)/nevents_ << " heap allocations per event on average, "
+                                      << max_ << " at most";
+}
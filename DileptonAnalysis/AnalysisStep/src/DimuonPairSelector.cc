@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/DimuonPairSelector.h"
+
+DimuonPairSelector::DimuonPairSelector(const edm::ParameterSet& iConfig):
+    requireOppositeCharge_(iConfig.existsAs<bool>    ("requireOppositeCharge") ? iConfig.getParameter<bool>    ("requireOppositeCharge") : false),
+    minPairDR_            (iConfig.existsAs<double>  ("minPairDR")             ? iConfig.getParameter<double>  ("minPairDR")             : -1.),
+    maxPairDR_            (iConfig.existsAs<double>  ("maxPairDR")             ? iConfig.getParameter<double>  ("maxPairDR")             : -1.),
+    minPairMass_          (iConfig.existsAs<double>  ("minPairMass")           ? iConfig.getParameter<double>  ("minPairMass")           : -1.),
+    maxPairMass_          (iConfig.existsAs<double>  ("maxPairMass")           ? iConfig.getParameter<double>  ("maxPairMass")           : -1.),
+    maxFittedPairs_       (iConfig.existsAs<unsigned>("maxFittedPairs")        ? iConfig.getParameter<unsigned>("maxFittedPairs")        : 0),
+    nConsidered_(0),
+    nPreselected_(0),
+    nSelected_(0)
+{
+}
+
+void DimuonPairSelector::select(const std::vector<pat::MuonRef>& muons, const std::vector<unsigned>& goodIdx, std::vector<DimuonPairCandidate>& pairs) {
+    pairs.clear();
+    nConsidered_  = 0;
+    nPreselected_ = 0;
+    nSelected_    = 0;
+
+    for (size_t i = 0; i < goodIdx.size(); i++) {
+        const pat::Muon& mu1 = *muons[goodIdx[i]];
+        for (size_t j = i+1; j < goodIdx.size(); j++) {
+            const pat::Muon& mu2 = *muons[goodIdx[j]];
+            nConsidered_++;
+
+            if (requireOppositeCharge_ && mu1.charge() * mu2.charge() >= 0) continue;
+
+            if (minPairDR_ >= 0. || maxPairDR_ >= 0.) {
+                double dR = reco::deltaR(mu1, mu2);
+                if (minPairDR_ >= 0. && dR < minPairDR_) continue;
+                if (maxPairDR_ >= 0. && dR > maxPairDR_) continue;
+            }
+
+            if (minPairMass_ >= 0. || maxPairMass_ >= 0.) {
+                double mass = (mu1.p4() + mu2.p4()).mass();
+                if (minPairMass_ >= 0. && mass < minPairMass_) continue;
+                if (maxPairMass_ >= 0. && mass > maxPairMass_) continue;
+            }
+
+            DimuonPairCandidate pair;
+            pair.first  = goodIdx[i];
+            pair.second = goodIdx[j];
+            pair.sumPt  = mu1.pt() + mu2.pt();
+            pairs.push_back(pair);
+        }
+    }
+    nPreselected_ = pairs.size();
+
+    // Rank by scalar pT sum, only the leading maxFittedPairs need to be in order
+    auto higherSumPt = [](const DimuonPairCandidate& a, const DimuonPairCandidate& b) { return a.sumPt > b.sumPt; };
+    if (maxFittedPairs_ > 0 && pairs.size() > maxFittedPairs_) {
+        std::partial_sort(pairs.begin(), pairs.begin() + maxFittedPairs_, pairs.end(), higherSumPt);
+        pairs.resize(maxFittedPairs_);
+    }
+    else std::sort(pairs.begin(), pairs.end(), higherSumPt);
+    nSelected_ = pairs.size();
+}
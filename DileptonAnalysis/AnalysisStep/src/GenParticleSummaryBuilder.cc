@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummaryBuilder.h"
+
+GenParticleSummaryBuilder::GenParticleSummaryBuilder(const std::vector<int>& pdgIds):
+    pdgIds_(pdgIds)
+{
+    for (int& pdgId : pdgIds_) pdgId = std::abs(pdgId);
+    std::sort(pdgIds_.begin(), pdgIds_.end());
+}
+
+GenParticleSummaryBuilder::GenParticleSummaryBuilder(const edm::ParameterSet& iConfig, edm::ConsumesCollector&& iC, const std::vector<int>& pdgIds):
+    GenParticleSummaryBuilder(pdgIds)
+{
+    if (iConfig.existsAs<edm::InputTag>("genSummary")) genSummaryToken_ = iC.consumes<GenParticleSummary>(iConfig.getParameter<edm::InputTag>("genSummary"));
+    else                                               gensToken_       = iC.consumes<std::vector<reco::GenParticle> >(iConfig.getParameter<edm::InputTag>("gens"));
+}
+
+bool GenParticleSummaryBuilder::keep(int pdgId) const {
+    return pdgIds_.empty() || std::binary_search(pdgIds_.begin(), pdgIds_.end(), std::abs(pdgId));
+}
+
+void GenParticleSummaryBuilder::fill(const std::vector<reco::GenParticle>& gens, GenParticleSummary& summary) const {
+    summary.clear();
+    for (const reco::GenParticle& gen : gens) {
+        if (not keep(gen.pdgId())) continue;
+
+        unsigned short flags = 0;
+        if (gen.fromHardProcessFinalState()) flags |= GenParticleSummary::fromHardProcessFinalState;
+        if (gen.isPromptFinalState())        flags |= GenParticleSummary::isPromptFinalState;
+        if (gen.isHardProcess())             flags |= GenParticleSummary::isHardProcess;
+        if (gen.isLastCopy())                flags |= GenParticleSummary::isLastCopy;
+
+        summary.pdgId .push_back(gen.pdgId());
+        summary.status.push_back(gen.status());
+        summary.flags .push_back(flags);
+        summary.pt    .push_back(gen.pt());
+        summary.eta   .push_back(gen.eta());
+        summary.phi   .push_back(gen.phi());
+        summary.mass  .push_back(gen.mass());
+        summary.vx    .push_back(gen.vx());
+        summary.vy    .push_back(gen.vy());
+        summary.vz    .push_back(gen.vz());
+        summary.vrho  .push_back(std::hypot(gen.vx(), gen.vy()));
+    }
+}
+
+const GenParticleSummary* GenParticleSummaryBuilder::get(const edm::Event& iEvent) {
+    if (not genSummaryToken_.isUninitialized()) {
+        edm::Handle<GenParticleSummary> genSummaryH;
+        iEvent.getByToken(genSummaryToken_, genSummaryH);
+        return genSummaryH.isValid() ? genSummaryH.product() : nullptr;
+    }
+
+    edm::Handle<std::vector<reco::GenParticle> > gensH;
+    iEvent.getByToken(gensToken_, gensH);
+    if (not gensH.isValid()) return nullptr;
+    fill(*gensH, summary_);
+    return &summary_;
+}
@@ -0,0 +1,90 @@
+#include <cmath>
+
+#include "DileptonAnalysis/AnalysisStep/interface/JetSummary.h"
+
+JetSummary::JetSummary(const std::string& pileupDiscriminant, const std::string& bTagDiscriminant):
+    pileupDiscriminant_(pileupDiscriminant),
+    bTagDiscriminant_  (bTagDiscriminant),
+    bTagIndex_         (-1)
+{
+}
+
+void JetSummary::checkBTagIndex(const pat::Jet& jet) {
+    const std::vector<std::pair<std::string, float> >& bTags = jet.getPairDiscri();
+    if (bTagIndex_ < 0 || size_t(bTagIndex_) >= bTags.size() || bTags[bTagIndex_].first != bTagDiscriminant_) {
+        bTagIndex_ = -1;
+        for (size_t i = 0; i < bTags.size(); i++) {
+            if (bTags[i].first == bTagDiscriminant_) {
+                bTagIndex_ = i;
+                break;
+            }
+        }
+    }
+}
+
+void JetSummary::fill(const std::vector<pat::JetRef>& jets) {
+    size_t n = jets.size();
+    absEta_    .resize(n);
+    nhf_       .resize(n);
+    nemf_      .resize(n);
+    chf_       .resize(n);
+    muf_       .resize(n);
+    chm_       .resize(n);
+    nnp_       .resize(n);
+    pileupDisc_.resize(n);
+    bTag_      .resize(n);
+    id_        .resize(n);
+    if (n == 0) return;
+
+    checkBTagIndex(*jets[0]);
+
+    for (size_t i = 0; i < n; i++) {
+        const pat::Jet& jet = *jets[i];
+        absEta_[i] = std::fabs(jet.eta());
+        nhf_   [i] = jet.neutralHadronEnergyFraction();
+        nemf_  [i] = jet.neutralEmEnergyFraction();
+        chf_   [i] = jet.chargedHadronEnergyFraction();
+        muf_   [i] = jet.muonEnergyFraction();
+        chm_   [i] = jet.chargedMultiplicity();
+        nnp_   [i] = jet.neutralMultiplicity();
+
+        pileupDisc_[i] = jet.userFloat(pileupDiscriminant_);
+
+        const std::vector<std::pair<std::string, float> >& bTags = jet.getPairDiscri();
+        if (bTagIndex_ >= 0 && size_t(bTagIndex_) < bTags.size()) bTag_[i] = bTags[bTagIndex_].second;
+        else                                                      bTag_[i] = jet.bDiscriminator(bTagDiscriminant_);
+    }
+
+    evaluate();
+}
+
+void JetSummary::evaluate() {
+    for (size_t i = 0; i < absEta_.size(); i++) {
+        double eta  = absEta_[i];
+        float  nhf  = nhf_[i];
+        float  nemf = nemf_[i];
+        float  chf  = chf_[i];
+        float  muf  = muf_[i];
+        // As in the original TreeMaker::getJetID the charged EM fraction cut is applied to the muon energy fraction
+        float  cemf = muf_[i];
+        int    chm  = chm_[i];
+        int    nnp  = nnp_[i];
+        int    np   = chm + nnp;
+
+        unsigned central = eta <= 2.4;
+        unsigned barrel  = eta <= 2.7;
+        unsigned endcap  = (eta > 2.7) & (eta <= 3.0) & (nemf < 0.90) & (nnp > 2);
+        unsigned forward = (eta > 3.0) & (nemf < 0.90) & (nnp > 10);
+        unsigned charged = (chf > 0) & (chm > 0);
+
+        unsigned loose   = barrel & (nhf < 0.99) & (nemf < 0.99) & (np > 1) & ((central & charged & (cemf < 0.99)) | !central);
+        unsigned tight   = barrel & (nhf < 0.90) & (nemf < 0.90) & (np > 1) & ((central & charged & (cemf < 0.99)) | !central);
+        unsigned lepVeto = barrel & (nhf < 0.90) & (nemf < 0.90) & (np > 1) & (muf < 0.8) & ((central & charged & (cemf < 0.90)) | !central);
+
+        double   puCut   = eta < 2.50 ? -0.63 : eta < 2.75 ? -0.60 : eta < 3.00 ? -0.55 : -0.45;
+        unsigned puID    = (eta < 5.0) & (pileupDisc_[i] > puCut);
+
+        id_[i]   = (loose | endcap | forward) * looseID + (tight | endcap | forward) * tightID + (lepVeto | endcap | forward) * tightLepVetoID + puID * pileupID;
+        bTag_[i] = eta < 2.4 ? bTag_[i] : -10.f;
+    }
+}
@@ -0,0 +1,60 @@
+#include <algorithm>
+
+#include <TH1.h>
+#include <TAxis.h>
+
+#include "DileptonAnalysis/AnalysisStep/interface/LookupGrid.h"
+
+LookupGrid::Axis::Axis():
+    nbins  (0),
+    min    (0.),
+    max    (0.),
+    uniform(true)
+{
+}
+
+LookupGrid::Axis::Axis(const TAxis& axis):
+    nbins  (axis.GetNbins()),
+    min    (axis.GetXmin()),
+    max    (axis.GetXmax()),
+    uniform(axis.GetXbins()->GetSize() == 0)
+{
+    if (uniform) return;
+    edges.assign(axis.GetXbins()->GetArray(), axis.GetXbins()->GetArray() + nbins + 1);
+}
+
+int LookupGrid::Axis::findEdge(double x) const {
+    // Index of the first edge above x, edges[0] <= x < edges[nbins] here
+    int bin = std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+    return std::min(bin, nbins);
+}
+
+LookupGrid::LookupGrid() {
+}
+
+LookupGrid::LookupGrid(const TH1& hist):
+    xaxis_(*hist.GetXaxis())
+{
+    if (hist.GetDimension() > 1) yaxis_ = Axis(*hist.GetYaxis());
+
+    int nx = xaxis_.nbins + 2;
+    int ny = hist.GetDimension() > 1 ? yaxis_.nbins + 2 : 1;
+    values_.resize(nx * ny);
+    for (int i = 0; i < nx * ny; i++) values_[i] = hist.GetBinContent(i);
+}
+
+void LookupGrid::lookup(const float* x, size_t n, float* out) const {
+    for (size_t i = 0; i < n; i++) out[i] = (*this)(x[i]);
+}
+
+void LookupGrid::lookup(const float* x, const float* y, size_t n, float* out) const {
+    for (size_t i = 0; i < n; i++) out[i] = (*this)(x[i], y[i]);
+}
+
+void LookupGrid::multiply(const float* x, size_t n, float* out) const {
+    for (size_t i = 0; i < n; i++) out[i] *= (*this)(x[i]);
+}
+
+void LookupGrid::multiply(const float* x, const float* y, size_t n, float* out) const {
+    for (size_t i = 0; i < n; i++) out[i] *= (*this)(x[i], y[i]);
+}
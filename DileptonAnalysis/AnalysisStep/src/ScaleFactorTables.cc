@@ -0,0 +1,41 @@
+#include <TFile.h>
+#include <TH1.h>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/ScaleFactorTables.h"
+
+namespace {
+    std::unique_ptr<TH1> readHistogram(const std::string& filename, const std::string& histname) {
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str()));
+        if (not file || file->IsZombie()) throw cms::Exception("ScaleFactorTables") << "Cannot open " << filename;
+        TH1* hist = dynamic_cast<TH1*>(file->Get(histname.c_str()));
+        if (hist == nullptr) throw cms::Exception("ScaleFactorTables") << "No histogram " << histname << " in " << filename;
+        std::unique_ptr<TH1> clone(static_cast<TH1*>(hist->Clone()));
+        clone->SetDirectory(nullptr);
+        return clone;
+    }
+}
+
+ScaleFactorTables::ScaleFactorTables(const std::string& puDataFile, const std::string& muonSFFile):
+    puData_ (readHistogram(puDataFile, "pileup")),
+    muonID_ (*readHistogram(muonSFFile, "scalefactors_MuonMediumId_Muon")),
+    muonIso_(*readHistogram(muonSFFile, "scalefactors_Iso_MuonMediumId"))
+{
+    if (not (puData_->Integral() > 0.)) throw cms::Exception("Configuration") << "Empty pileup profile in " << puDataFile;
+    puData_->Scale(1./puData_->Integral());
+}
+
+ScaleFactorTables::~ScaleFactorTables() {
+}
+
+LookupGrid ScaleFactorTables::puWeights(const TH1& puMC) const {
+    // An empty MC profile, or one outside the range of the data profile, would give NaN/inf weights
+    if (not (puMC.Integral() > 0.)) throw cms::Exception("Configuration") << "Empty MC pileup profile " << puMC.GetName() << " (no MC event, or all the true pileup values outside the range of the data profile)";
+
+    std::unique_ptr<TH1> ratio(static_cast<TH1*>(puData_->Clone("histoRatio")));
+    ratio->SetDirectory(nullptr);
+    ratio->Divide(&puMC);
+    ratio->Scale(puMC.Integral());
+    return LookupGrid(*ratio);
+}
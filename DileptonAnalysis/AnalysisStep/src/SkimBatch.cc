@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TStopwatch.h>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimBatch.h"
+#include "DileptonAnalysis/AnalysisStep/interface/ScaleFactorTables.h"
+
+std::vector<SkimSample> readSkimSampleList(const std::string& filename, const std::string& outputDir) {
+    std::ifstream file(filename);
+    if (not file) throw cms::Exception("SkimBatch") << "Cannot open the sample list " << filename;
+
+    std::vector<SkimSample> samples;
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string first;
+        if (not (fields >> first) || first[0] == '#') continue;
+
+        SkimSample sample;
+        sample.name = first;
+        int isMC = 0;
+        if (not (fields >> sample.inputFiles >> isMC >> sample.xsec)) {
+            throw cms::Exception("SkimBatch") << filename << ":" << lineNumber << " : expected <name> <input files> <isMC> <xsec> [<output file>]";
+        }
+        sample.isMC = (isMC != 0);
+        if (not (fields >> sample.outputFile)) sample.outputFile = outputDir + "/" + sample.name + ".root";
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+SkimBatch::SkimBatch(const std::vector<SkimSample>& samples, const SkimConfig& baseConfig, unsigned nWorkers):
+    samples_   (samples),
+    baseConfig_(baseConfig),
+    nWorkers_  (std::max(1u, nWorkers)),
+    summaries_ (samples.size()),
+    errors_    (samples.size()),
+    bytesRead_ (0),
+    seconds_   (0.0)
+{
+}
+
+unsigned SkimBatch::run() {
+    TStopwatch timer;
+    timer.Start();
+
+    if (not ROOT::IsImplicitMTEnabled()) ROOT::EnableImplicitMT(baseConfig_.nThreads);
+    Long64_t bytesBefore = TFile::GetFileBytesRead();
+
+    // Tables shared by all the MC samples
+    std::shared_ptr<const ScaleFactorTables> tables;
+    bool hasMC = std::any_of(samples_.begin(), samples_.end(), [](const SkimSample& sample) { return sample.isMC; });
+    if (hasMC) tables = std::make_shared<const ScaleFactorTables>(baseConfig_.puDataFile, baseConfig_.muonSFFile);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < samples_.size(); i = next++) {
+            SkimConfig config = baseConfig_;
+            config.inputFiles = samples_[i].inputFiles;
+            config.outputFile = samples_[i].outputFile;
+            config.isMC       = samples_[i].isMC;
+            config.xsec       = samples_[i].xsec;
+            if (not baseConfig_.cacheDir.empty()) config.cacheDir = baseConfig_.cacheDir + "/" + samples_[i].name;
+
+            try {
+                SkimEngine engine(config, tables);
+                summaries_[i] = engine.run();
+            }
+            catch (const std::exception& e) {
+                errors_[i] = e.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::min<size_t>(nWorkers_, samples_.size()); i++) workers.emplace_back(worker);
+    for (std::thread& thread : workers) thread.join();
+
+    timer.Stop();
+    seconds_   = timer.RealTime();
+    bytesRead_ = TFile::GetFileBytesRead() - bytesBefore;
+
+    return std::count_if(errors_.begin(), errors_.end(), [](const std::string& error) { return not error.empty(); });
+}
+
+void SkimBatch::report(std::ostream& out) const {
+    out << std::left  << std::setw(24) << "Sample"
+        << std::right << std::setw(8)  << "Files"
+        << std::setw(8)  << "Cached"
+        << std::setw(14) << "Events"
+        << std::setw(12) << "Selected"
+        << std::setw(10) << "Time (s)"
+        << std::setw(12) << "kEvents/s"
+        << std::setw(10) << "MB/s"
+        << std::endl;
+
+    unsigned long long totalEvents = 0;
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < samples_.size(); i++) {
+        const SkimSummary& summary = summaries_[i];
+        out << std::left << std::setw(24) << samples_[i].name << std::right;
+        if (not errors_[i].empty()) {
+            out << "  FAILED : " << errors_[i] << std::endl;
+            continue;
+        }
+
+        double seconds = std::max(summary.seconds, 1e-6);
+        out << std::setw(8)  << summary.nFiles
+            << std::setw(8)  << summary.nFilesReused
+            << std::setw(14) << summary.nEvents
+            << std::setw(12) << summary.nSelected
+            << std::setw(10) << summary.seconds
+            << std::setw(12) << summary.nEvents/seconds/1e3;
+        // The bytes read by the samples skimmed at the same time cannot be told apart
+        if (nWorkers_ == 1) out << std::setw(10) << (summary.bytesRead + summary.genBytesRead)/seconds/1048576.;
+        else                out << std::setw(10) << "-";
+        out << std::endl;
+
+        totalEvents += summary.nEvents;
+    }
+
+    double seconds = std::max(seconds_, 1e-6);
+    out << "Total : " << totalEvents << " events in " << seconds_ << " s (wall), "
+        << totalEvents/seconds/1e3 << " kEvents/s, " << bytesRead_/seconds/1048576. << " MB/s, "
+        << nWorkers_ << " samples at a time" << std::endl;
+}
+
+void SkimBatch::reportCutflow(std::ostream& out) const {
+    for (size_t i = 0; i < samples_.size(); i++) {
+        if (not errors_[i].empty()) continue;
+        out << std::endl << samples_[i].name << std::endl;
+        printSkimCutflow(out, summaries_[i]);
+    }
+}
@@ -0,0 +1,899 @@
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TChain.h>
+#include <TH1D.h>
+#include <TLorentzVector.h>
+#include <TStopwatch.h>
+#include <TTreeReader.h>
+#include <TTreeReaderValue.h>
+#include <ROOT/TTreeProcessorMT.hxx>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimEngine.h"
+#include "DileptonAnalysis/AnalysisStep/interface/WeightSummary.h"
+#include "DileptonAnalysis/AnalysisStep/interface/ScaleFactorTables.h"
+#include "DileptonAnalysis/AnalysisStep/interface/SkimManifest.h"
+#include "DileptonAnalysis/AnalysisStep/interface/PairIndex.h"
+
+namespace {
+
+    // Stages of the selection, in their default order, and the columns they read
+    // - trigger            : hltsinglemu
+    // - dimuon ID/iso      : muons, mid, midmedium, miso
+    // - trigger match      : mhlt
+    // - pair mass error    : masserr (and m1idx, m2idx for the files older than the PairIndex.h layout)
+    // - jets               : jets, jid, jbtag
+    // - MET, event info    : t1met, t1metphi, run, lumSec, event, xsec, wgt, nvtx
+    // The cost is a rough relative estimate, used to order the independent stages before they
+    // are timed. Independent stages do not use the result of another stage, they come first
+    // and may be evaluated in any order; the others need the muons chosen by the dimuon stage.
+    enum SelectionStage {
+        triggerStage,
+        dimuonStage,
+        triggerMatchStage,
+        massErrorStage,
+        jetStage,
+        eventStage,
+        nSelectionStages
+    };
+
+    struct StageInfo {
+        const char* name;
+        unsigned    cost;
+        bool        independent;
+    };
+
+    const StageInfo stageInfo[nSelectionStages] = {
+        {"trigger"      ,  1, true },
+        {"dimuon"       , 10, true },
+        {"trigger match",  1, false},
+        {"mass error"   ,  5, false},
+        {"jets"         , 20, false},
+        {"MET, event"   ,  2, false}
+    };
+
+    std::vector<SkimStageStats> skimStageStats() {
+        std::vector<SkimStageStats> stats(nSelectionStages);
+        for (int stage = 0; stage < nSelectionStages; stage++) {
+            stats[stage].name = stageInfo[stage].name;
+            stats[stage].cost = stageInfo[stage].cost;
+        }
+        return stats;
+    }
+
+    // Order of evaluation of the stages and their counts and time, one per task
+    //
+    // When reordering, the independent stages are first ordered by cost, then every
+    // reorderInterval entries by increasing (time per evaluation) / (rejection rate), which
+    // rejects the entries earliest for the least time when the cuts are uncorrelated.
+    //
+    // Reading the clock costs more than the cheapest stages, so the stages are only timed for
+    // one entry in timingInterval, and their time is scaled up to estimate the total.
+    class StageRunner {
+        public:
+            explicit StageRunner(bool reorder);
+
+            // Evaluate the stages with evaluate(stage) until one of them fails
+            template <class F>
+            bool run(F evaluate);
+
+            void addTo(std::vector<SkimStageStats>& stats) const;
+
+        private:
+            void reorder();
+
+            static const unsigned long long reorderInterval = 4096;
+            static const unsigned long long timingInterval  = 64;
+            static const unsigned long long minEvaluated    = 256;
+
+            std::vector<int>            order_;
+            std::vector<SkimStageStats> stats_;
+            bool                        reorder_;
+            unsigned long long          nEntries_;
+    };
+
+    StageRunner::StageRunner(bool reorder):
+        stats_   (skimStageStats()),
+        reorder_ (reorder),
+        nEntries_(0)
+    {
+        for (int stage = 0; stage < nSelectionStages; stage++) order_.push_back(stage);
+        if (reorder_) {
+            auto firstDependent = std::find_if(order_.begin(), order_.end(), [](int stage) { return not stageInfo[stage].independent; });
+            std::stable_sort(order_.begin(), firstDependent, [](int a, int b) { return stageInfo[a].cost < stageInfo[b].cost; });
+        }
+    }
+
+    template <class F>
+    bool StageRunner::run(F evaluate) {
+        ++nEntries_;
+        if (reorder_ && nEntries_ % reorderInterval == 0) reorder();
+
+        if (nEntries_ % timingInterval != 0) {
+            for (int stage : order_) {
+                SkimStageStats& stats = stats_[stage];
+                stats.nEvaluated++;
+                if (not evaluate(stage)) return false;
+                stats.nPassed++;
+            }
+            return true;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int stage : order_) {
+            bool pass = evaluate(stage);
+            auto stop = std::chrono::steady_clock::now();
+
+            SkimStageStats& stats = stats_[stage];
+            stats.seconds += std::chrono::duration<double>(stop - start).count() * timingInterval;
+            stats.nEvaluated++;
+            if (not pass) return false;
+            stats.nPassed++;
+            start = stop;
+        }
+        return true;
+    }
+
+    void StageRunner::reorder() {
+        auto firstDependent = std::find_if(order_.begin(), order_.end(), [](int stage) { return not stageInfo[stage].independent; });
+        for (auto stage = order_.begin(); stage != firstDependent; ++stage) {
+            if (stats_[*stage].nEvaluated < minEvaluated) return;
+        }
+
+        auto rank = [this](int stage) {
+            const SkimStageStats& stats = stats_[stage];
+            double rejected = stats.nEvaluated - stats.nPassed;
+            if (rejected == 0) return std::numeric_limits<double>::max();
+            return stats.seconds / rejected;
+        };
+        std::stable_sort(order_.begin(), firstDependent, [&](int a, int b) { return rank(a) < rank(b); });
+    }
+
+    void StageRunner::addTo(std::vector<SkimStageStats>& stats) const {
+        for (size_t i = 0; i < stats_.size(); i++) {
+            stats[i].nEvaluated += stats_[i].nEvaluated;
+            stats[i].nPassed    += stats_[i].nPassed;
+            stats[i].seconds    += stats_[i].seconds;
+        }
+    }
+
+    // Branches of mmtree/tree used by the skim, one set per TTreeReader
+    //
+    // TTreeReaderValues read their branch only when dereferenced, so each stage of the selection
+    // only reads its columns for the entries that passed the previous stages.
+    // The pileup profile needs putrue for all the MC entries.
+    class MMTreeReader {
+        public:
+            MMTreeReader(TTreeReader& reader, unsigned triggerMatchBits):
+                run    (reader, "run"        ),
+                lumSec (reader, "lumSec"     ),
+                event  (reader, "event"      ),
+                xsec   (reader, "xsec"       ),
+                wgt    (reader, "wgt"        ),
+                nvtx   (reader, "nvtx"       ),
+                putrue (reader, "putrue"     ),
+                m1idx  (reader, "m1idx"      ),
+                m2idx  (reader, "m2idx"      ),
+                masserr(reader, "masserr"    ),
+                muons  (reader, "muons"      ),
+                miso   (reader, "miso"       ),
+                mid    (reader, "mid"        ),
+                midmed (reader, "midmedium"  ),
+                mhlt   (reader, "mhlt"       ),
+                hlt1m  (reader, "hltsinglemu"),
+                jets   (reader, "jets"       ),
+                jid    (reader, "jid"        ),
+                jbtag  (reader, "jbtag"      ),
+                etm    (reader, "t1met"      ),
+                etmphi (reader, "t1metphi"   ),
+                idx1   (-1),
+                idx2   (-1),
+                matchBits (triggerMatchBits),
+                pairLayout(true)
+            {
+            }
+
+            // Whether the pair quantities of the current file follow PairIndex.h, which TreeMaker
+            // files have since they store the pairVtxProb branch. For older files the mass error
+            // of the chosen pair is searched for with m1idx and m2idx.
+            void setPairLayout(TTree* tree) {
+                pairLayout = (tree->GetBranch("pairVtxProb") != nullptr);
+            }
+
+            // Apply the dimuon selection to the current entry and fill record if it passes
+            bool select(SkimRecord& record, StageRunner& stages) {
+                return stages.run([&](int stage) { return evaluate(stage, record); });
+            }
+
+            // Columns read for (nearly) every entry, i.e. those of the trigger and dimuon stages
+            static std::vector<std::string> cheapColumns(bool isMC) {
+                std::vector<std::string> columns = {"hltsinglemu", "muons", "mid", "midmedium", "miso"};
+                if (isMC) columns.push_back("putrue");
+                return columns;
+            }
+
+            TTreeReaderValue<unsigned>                     run;
+            TTreeReaderValue<unsigned>                     lumSec;
+            TTreeReaderValue<unsigned>                     event;
+            TTreeReaderValue<double>                       xsec;
+            TTreeReaderValue<double>                       wgt;
+            TTreeReaderValue<unsigned char>                nvtx;
+            TTreeReaderValue<unsigned char>                putrue;
+            TTreeReaderValue<std::vector<unsigned char> >  m1idx;
+            TTreeReaderValue<std::vector<unsigned char> >  m2idx;
+            TTreeReaderValue<std::vector<double> >         masserr;
+            TTreeReaderValue<std::vector<TLorentzVector> > muons;
+            TTreeReaderValue<std::vector<double> >         miso;
+            TTreeReaderValue<std::vector<int> >            mid;
+            TTreeReaderValue<std::vector<bool> >           midmed;
+            TTreeReaderValue<std::vector<unsigned> >       mhlt;
+            TTreeReaderValue<unsigned char>                hlt1m;
+            TTreeReaderValue<std::vector<TLorentzVector> > jets;
+            TTreeReaderValue<std::vector<char> >           jid;
+            TTreeReaderValue<std::vector<double> >         jbtag;
+            TTreeReaderValue<double>                       etm;
+            TTreeReaderValue<double>                       etmphi;
+
+        private:
+            bool evaluate(int stage, SkimRecord& record);
+
+            // Muons chosen by the dimuon stage
+            int idx1;
+            int idx2;
+
+            // Bits of mhlt standing for the single muon trigger paths
+            unsigned matchBits;
+
+            bool pairLayout;
+    };
+
+    bool MMTreeReader::evaluate(int stage, SkimRecord& record) {
+        switch (stage) {
+
+        // Require the event to fire the single muon trigger
+        case triggerStage :
+            return *hlt1m >= 1;
+
+        // Require two OS muons passing the medium ID and loose isolation
+        // Take the leading combination (in terms muon pT) in case of multiple possible dimuon combinations
+        // mid is the PDG ID of the muon, the product of two of them is negative for OS muons
+        case dimuonStage :
+            idx1 = -1;
+            idx2 = -1;
+            for (size_t i = 0; i < muons->size(); i++) {
+                if (idx1 >= 0 && idx2 >= 0) continue;
+
+                if (not midmed->at(i)) continue;
+                if (miso->at(i) > 0.25) continue;
+
+                if (idx1 < 0) idx1 = i;
+                else {
+                    if (mid->at(idx1) * mid->at(i) < 0) idx2 = i;
+                }
+            }
+            return idx1 >= 0 && idx2 >= 0;
+
+        // Require at least one of the muons to fire the trigger and have pT > 30 GeV (single muon trigger plateau)
+        case triggerMatchStage : {
+            const TLorentzVector& mu1 = muons->at(idx1);
+            const TLorentzVector& mu2 = muons->at(idx2);
+
+            char m1id = 1;
+            char m2id = 1;
+            if ((mhlt->at(idx1) & matchBits) != 0) m1id += 2;
+            if ((mhlt->at(idx2) & matchBits) != 0) m2id += 2;
+
+            bool triggervalid = false;
+            if (m1id == 3 && mu1.Pt() > 30.0) triggervalid = true;
+            if (m2id == 3 && mu2.Pt() > 30.0) triggervalid = true;
+            if (not triggervalid) return false;
+
+            // Sign of the ID value is the one of the muon PDG ID
+            // ID value is 1 if the muon only passes the ID/iso requirements
+            // ID value is 3 if the muon also fires the HLT
+            if (mid->at(idx1) < 0) m1id *= -1;
+            if (mid->at(idx2) < 0) m2id *= -1;
+
+            record.m1pt   = mu1.Pt();
+            record.m1eta  = mu1.Eta();
+            record.m1phi  = mu1.Phi();
+            record.m1id   = m1id;
+            record.m2pt   = mu2.Pt();
+            record.m2eta  = mu2.Eta();
+            record.m2phi  = mu2.Phi();
+            record.m2id   = m2id;
+
+            TLorentzVector mm = mu1 + mu2;
+            record.mmpt   = mm.Pt();
+            record.mmeta  = mm.Eta();
+            record.mmphi  = mm.Phi();
+            record.mass   = mm.M();
+            return true;
+        }
+
+        case massErrorStage :
+            record.merr   = -1.0;
+            if (pairLayout) {
+                size_t slot = pairSlot(idx1, idx2);
+                if (slot < masserr->size()) record.merr = (*masserr)[slot];
+            }
+            else {
+                for (size_t i = 0; i < masserr->size(); i++) {
+                    if (m1idx->at(i) == idx1 && m2idx->at(i) == idx2) record.merr = masserr->at(i);
+                }
+            }
+            return true;
+
+        // Jet is required to have pT > 30 GeV, |eta| < 4.7, and pass the loose jet ID
+        case jetStage : {
+            const TLorentzVector& mu1 = muons->at(idx1);
+            const TLorentzVector& mu2 = muons->at(idx2);
+
+            record.njets  = 0;
+            record.nbjets = 0;
+            for (size_t i = 0; i < jets->size(); i++) {
+                if ((jid->at(i) & 1) == 0  ) continue;
+                if (jets->at(i).Pt() < 30.0) continue;
+                if (std::fabs(jets->at(i).Eta()) > 4.7) continue;
+                if (jets->at(i).DeltaR(mu1) < 0.4) continue;
+                if (jets->at(i).DeltaR(mu2) < 0.4) continue;
+
+                record.njets++;
+                if (jbtag->at(i) > 0.8484) record.nbjets++;
+            }
+            return true;
+        }
+
+        case eventStage :
+            record.met    = *etm;
+            record.metphi = *etmphi;
+
+            record.run    = *run;
+            record.lumSec = *lumSec;
+            record.event  = *event;
+            record.wgt    = *wgt;
+            record.xsec   = *xsec;
+            record.putrue = *putrue;
+            record.nvtx   = *nvtx;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Columns of mmtree/tree read by the skim, and the TreeMaker setting that stores them when
+    // they are not always there
+    struct RequiredColumn {
+        const char* name;
+        bool        mcOnly;
+        const char* setting;
+    };
+
+    const RequiredColumn requiredColumns[] = {
+        {"hltsinglemu", false, nullptr                      },
+        {"muons"      , false, nullptr                      },
+        {"mid"        , false, nullptr                      },
+        {"midmedium"  , false, nullptr                      },
+        {"miso"       , false, nullptr                      },
+        {"masserr"    , false, nullptr                      },
+        {"jets"       , false, nullptr                      },
+        {"jid"        , false, nullptr                      },
+        {"jbtag"      , false, nullptr                      },
+        {"xsec"       , false, nullptr                      },
+        {"wgt"        , false, nullptr                      },
+        {"nvtx"       , false, nullptr                      },
+        {"putrue"     , true , nullptr                      },
+        {"run"        , false, "addEventInfo = True"        },
+        {"lumSec"     , false, "addEventInfo = True"        },
+        {"event"      , false, "addEventInfo = True"        },
+        {"t1met"      , false, "'type1' in metColumns"      },
+        {"t1metphi"   , false, "'type1' in metColumns"      },
+        {"mhlt"       , false, "hltMatchPaths (the single muon paths being the bits of SkimConfig::triggerMatchBits)"}
+    };
+
+    // Throw if mmtree/tree of the file lacks a column of the skim, before TTreeReader binds the columns
+    void checkColumns(const std::string& filename, bool isMC) {
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str()));
+        if (not file || file->IsZombie()) throw cms::Exception("SkimEngine") << "Cannot open " << filename;
+        TTree* tree = dynamic_cast<TTree*>(file->Get("mmtree/tree"));
+        if (tree == nullptr) throw cms::Exception("SkimEngine") << "No mmtree/tree in " << filename;
+
+        for (const RequiredColumn& column : requiredColumns) {
+            if (column.mcOnly && not isMC) continue;
+            if (tree->GetBranch(column.name) != nullptr) continue;
+
+            cms::Exception exception("SkimEngine");
+            exception << "Branch " << column.name << " not found in mmtree/tree of " << filename;
+            if (column.setting != nullptr) exception << ", the tree has to be made with TreeMaker " << column.setting;
+            throw exception;
+        }
+        if (tree->GetBranch("pairVtxProb") == nullptr && (tree->GetBranch("m1idx") == nullptr || tree->GetBranch("m2idx") == nullptr)) {
+            throw cms::Exception("SkimEngine") << "Neither pairVtxProb nor m1idx/m2idx found in mmtree/tree of " << filename << ", the mass error of the pair cannot be read";
+        }
+    }
+
+    // Version of the selection and of the content of the partial outputs, to be increased whenever
+    // one of them changes so that the partial outputs of the cache are remade
+    const unsigned skimVersion = 2;
+
+    // 64-bit FNV-1a hash, stable from one build to the next unlike std::hash
+    unsigned long long fnv1a(const std::string& text) {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Let the read cache prefetch the baskets of the given columns only, the other columns are
+    // then read directly, and only for the entries that need them
+    void restrictReadCache(TTree* tree, const std::vector<std::string>& columns) {
+        for (const std::string& column : columns) tree->AddBranchToCache(column.c_str(), true);
+        tree->StopCacheLearningPhase();
+    }
+
+    // Call f(name, address, leaf type) for each member of the record, to read or write it as a TTree entry
+    template <class F>
+    void forEachColumn(SkimRecord& r, F f) {
+        f("run"   , &r.run   , "i");
+        f("lumSec", &r.lumSec, "i");
+        f("event" , &r.event , "i");
+        f("wgt"   , &r.wgt   , "D");
+        f("xsec"  , &r.xsec  , "D");
+        f("putrue", &r.putrue, "b");
+        f("nvtx"  , &r.nvtx  , "b");
+        f("m1pt"  , &r.m1pt  , "D");
+        f("m1eta" , &r.m1eta , "D");
+        f("m1phi" , &r.m1phi , "D");
+        f("m1id"  , &r.m1id  , "B");
+        f("m2pt"  , &r.m2pt  , "D");
+        f("m2eta" , &r.m2eta , "D");
+        f("m2phi" , &r.m2phi , "D");
+        f("m2id"  , &r.m2id  , "B");
+        f("mmpt"  , &r.mmpt  , "D");
+        f("mmeta" , &r.mmeta , "D");
+        f("mmphi" , &r.mmphi , "D");
+        f("mass"  , &r.mass  , "D");
+        f("merr"  , &r.merr  , "D");
+        f("met"   , &r.met   , "D");
+        f("metphi", &r.metphi, "D");
+        f("njets" , &r.njets , "b");
+        f("nbjets", &r.nbjets, "b");
+    }
+}
+
+SkimConfig::SkimConfig():
+    isMC      (true),
+    xsec      (-1.),
+    puDataFile("../data/pudata.root"),
+    muonSFFile("../data/muonIDIsoSF.root"),
+    lumi      (35.9),
+    nThreads  (0),
+    lazyColumns(true),
+    reorderCuts(false),
+    triggerMatchBits(1)
+{
+}
+
+SkimSummary::SkimSummary():
+    nFiles        (0),
+    nFilesReused  (0),
+    nEvents       (0),
+    nSelected     (0),
+    nGenEvents    (0),
+    wgtsum        (1.0),
+    wgtsumFromTree(false),
+    bytesRead     (0),
+    genBytesRead  (0),
+    seconds       (0.0),
+    stages        (skimStageStats())
+{
+}
+
+SkimStageStats::SkimStageStats():
+    cost      (0),
+    nEvaluated(0),
+    nPassed   (0),
+    seconds   (0.0)
+{
+}
+
+SkimEngine::FileResult::FileResult():
+    pileup        (256, 0.),
+    nEvents       (0),
+    wgtsumFromTree(false)
+{
+}
+
+void SkimEngine::FileResult::add(const FileResult& other) {
+    records.insert(records.end(), other.records.begin(), other.records.end());
+    for (size_t i = 0; i < pileup.size(); i++) pileup[i] += other.pileup[i];
+    nEvents += other.nEvents;
+    weights.add(other.weights);
+}
+
+SkimEngine::SkimEngine(const SkimConfig& config, std::shared_ptr<const ScaleFactorTables> tables):
+    config_(config),
+    tables_(tables)
+{
+}
+
+std::string SkimEngine::fingerprint() const {
+    std::ostringstream description;
+    description << "version "    << skimVersion
+                << " isMC "      << config_.isMC
+                << " xsec "      << config_.xsec
+                << " lumi "      << config_.lumi
+                << " pudata "    << config_.puDataFile
+                << " muonsf "    << config_.muonSFFile
+                << " matchbits " << config_.triggerMatchBits;
+
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0') << fnv1a(description.str());
+    return hash.str();
+}
+
+std::vector<std::string> SkimEngine::expandInputs() const {
+    TChain chain("mmtree/tree");
+    chain.Add(config_.inputFiles.c_str());
+
+    std::vector<std::string> files;
+    for (TObject* element : *chain.GetListOfFiles()) files.push_back(element->GetTitle());
+    return files;
+}
+
+SkimSummary SkimEngine::run() {
+    TStopwatch timer;
+    timer.Start();
+
+    SkimSummary summary;
+
+    std::vector<std::string> files = expandInputs();
+    if (files.empty()) throw cms::Exception("SkimEngine") << "No input file matches " << config_.inputFiles;
+    summary.nFiles = files.size();
+
+    if (not ROOT::IsImplicitMTEnabled()) ROOT::EnableImplicitMT(config_.nThreads);
+    TH1::AddDirectory(kFALSE);
+
+    if (config_.isMC && not tables_) tables_ = std::make_shared<const ScaleFactorTables>(config_.puDataFile, config_.muonSFFile);
+
+    // Contributions of the input files, reused from the cache when the file did not change
+    std::vector<FileResult> results(files.size());
+    std::vector<size_t> toProcess;
+    std::unique_ptr<SkimManifest> manifest;
+    if (not config_.cacheDir.empty()) manifest.reset(new SkimManifest(config_.cacheDir, fingerprint()));
+    for (size_t i = 0; i < files.size(); i++) {
+        const SkimManifest::Entry* entry = manifest ? manifest->find(files[i]) : nullptr;
+        if (entry != nullptr && readPartial(entry->partialFile, results[i])) {
+            results[i].wgtsumFromTree = entry->wgtsumFromTree;
+            summary.nFilesReused++;
+        }
+        else toProcess.push_back(i);
+    }
+
+    for (size_t i : toProcess) checkColumns(files[i], config_.isMC);
+
+    // The bytes read by the event skim and by the weight sum are counted apart
+    if (not toProcess.empty()) {
+        Long64_t bytesBefore = TFile::GetFileBytesRead();
+        processFiles(files, toProcess, results, summary.stages);
+        summary.bytesRead = TFile::GetFileBytesRead() - bytesBefore;
+
+        if (config_.isMC) {
+            bytesBefore = TFile::GetFileBytesRead();
+            sumGenWeights(files, toProcess, results);
+            summary.genBytesRead = TFile::GetFileBytesRead() - bytesBefore;
+        }
+    }
+
+    if (manifest) {
+        for (size_t i : toProcess) {
+            SkimManifest::Entry entry;
+            if (not manifest->makeEntry(files[i], entry)) continue;
+            entry.wgtsumFromTree = results[i].wgtsumFromTree;
+            writePartial(entry.partialFile, results[i]);
+            manifest->update(entry);
+        }
+        manifest->retain(files);
+        manifest->write();
+    }
+
+    // Merge the contributions of all the files
+    std::vector<SkimRecord> records;
+    std::vector<double> pileup(256, 0.);
+    WeightSummary weights;
+    for (const FileResult& result : results) {
+        records.insert(records.end(), result.records.begin(), result.records.end());
+        for (size_t i = 0; i < pileup.size(); i++) pileup[i] += result.pileup[i];
+        weights.add(result.weights);
+        summary.nEvents += result.nEvents;
+        if (result.wgtsumFromTree) summary.wgtsumFromTree = true;
+    }
+    summary.nSelected = records.size();
+
+    // Sum of the signs of the generator weights, over all the generated events
+    if (config_.isMC) {
+        summary.wgtsum     = weights.sumw();
+        summary.nGenEvents = weights.nEvents();
+    }
+
+    // MC pileup profile with the binning of the data one
+    std::unique_ptr<TH1D> puMC;
+    if (config_.isMC) {
+        const TH1& puData = tables_->puData();
+        puMC.reset(new TH1D("histoPUMC", "", puData.GetNbinsX(), puData.GetXaxis()->GetXmin(), puData.GetXaxis()->GetXmax()));
+        for (size_t i = 0; i < pileup.size(); i++) puMC->Fill(i, pileup[i]);
+    }
+
+    writeOutput(records, summary, puMC.get());
+
+    timer.Stop();
+    summary.seconds = timer.RealTime();
+    return summary;
+}
+
+void SkimEngine::processFiles(const std::vector<std::string>& files, const std::vector<size_t>& toProcess, std::vector<FileResult>& results, std::vector<SkimStageStats>& stages) const {
+    std::unordered_map<std::string, size_t> fileIndex;
+    std::vector<std::string_view> fileViews;
+    for (size_t i : toProcess) {
+        fileIndex[files[i]] = i;
+        fileViews.push_back(files[i]);
+    }
+
+    std::mutex mergeMutex;
+    ROOT::TTreeProcessorMT treeProcessor(fileViews, "mmtree/tree");
+    treeProcessor.Process([&](TTreeReader& reader) {
+        MMTreeReader mmtree(reader, config_.triggerMatchBits);
+        StageRunner  runner(config_.reorderCuts);
+
+        // The task accumulates into its own FileResult, added to the one of the file when the file changes
+        FileResult partial;
+        TFile*     currentFile = nullptr;
+        size_t     index       = 0;
+        auto flush = [&]() {
+            if (currentFile == nullptr) return;
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            results[index].add(partial);
+            partial = FileResult();
+        };
+
+        SkimRecord record;
+        while (reader.Next()) {
+            TFile* file = reader.GetTree()->GetCurrentFile();
+            if (file != currentFile) {
+                flush();
+                auto found = fileIndex.find(file->GetName());
+                if (found == fileIndex.end()) throw cms::Exception("SkimEngine") << "Unexpected input file " << file->GetName();
+                currentFile = file;
+                index       = found->second;
+                mmtree.setPairLayout(reader.GetTree());
+                if (config_.lazyColumns) restrictReadCache(reader.GetTree(), MMTreeReader::cheapColumns(config_.isMC));
+            }
+
+            partial.nEvents++;
+            if (config_.isMC) partial.pileup[*mmtree.putrue]++;
+            if (mmtree.select(record, runner)) partial.records.push_back(record);
+        }
+        flush();
+
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        runner.addTo(stages);
+    });
+}
+
+void SkimEngine::sumGenWeights(const std::vector<std::string>& files, const std::vector<size_t>& toProcess, std::vector<FileResult>& results) const {
+
+    // Taken from the gentree/weights summaries when the file has one, otherwise from the gentree/tree entries
+    std::unordered_map<std::string, size_t> fileIndex;
+    std::vector<std::string_view> fileViews;
+    for (size_t i : toProcess) {
+        if (results[i].weights.add(std::vector<std::string>(1, files[i]))) continue;
+        results[i].wgtsumFromTree = true;
+        fileIndex[files[i]] = i;
+        fileViews.push_back(files[i]);
+    }
+    if (fileViews.empty()) return;
+
+    std::mutex mergeMutex;
+    ROOT::TTreeProcessorMT genProcessor(fileViews, "gentree/tree");
+    genProcessor.Process([&](TTreeReader& reader) {
+        TTreeReaderValue<double> wgtsign(reader, "wgtsign");
+
+        WeightSummary partial;
+        TFile*        currentFile = nullptr;
+        size_t        index       = 0;
+        auto flush = [&]() {
+            if (currentFile == nullptr) return;
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            results[index].weights.add(partial);
+            partial = WeightSummary();
+        };
+
+        while (reader.Next()) {
+            TFile* file = reader.GetTree()->GetCurrentFile();
+            if (file != currentFile) {
+                flush();
+                auto found = fileIndex.find(file->GetName());
+                if (found == fileIndex.end()) throw cms::Exception("SkimEngine") << "Unexpected input file " << file->GetName();
+                currentFile = file;
+                index       = found->second;
+            }
+            partial.fill(*wgtsign);
+        }
+        flush();
+    });
+}
+
+void SkimEngine::writePartial(const std::string& filename, const FileResult& result) const {
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "RECREATE"));
+    if (not file || file->IsZombie()) throw cms::Exception("SkimEngine") << "Cannot create " << filename;
+
+    TTree* tree = new TTree("records", "records");
+    SkimRecord record;
+    forEachColumn(record, [&](const char* name, void* address, const char* type) {
+        tree->Branch(name, address, (std::string(name) + "/" + type).c_str());
+    });
+    for (const SkimRecord& r : result.records) {
+        record = r;
+        tree->Fill();
+    }
+    tree->Write();
+
+    TH1D pileup("pileup", "", result.pileup.size(), 0., result.pileup.size());
+    for (size_t i = 0; i < result.pileup.size(); i++) pileup.SetBinContent(i+1, result.pileup[i]);
+    pileup.SetEntries(result.nEvents);
+    pileup.Write();
+
+    TH1D weights(WeightSummary::histogramName(), "", WeightSummary::nBins, 0., WeightSummary::nBins);
+    WeightSummary::setupHistogram(weights);
+    result.weights.write(weights);
+    weights.Write();
+
+    file->Close();
+}
+
+bool SkimEngine::readPartial(const std::string& filename, FileResult& result) const {
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str()));
+    if (not file || file->IsZombie()) return false;
+
+    TTree* tree    = dynamic_cast<TTree*>(file->Get("records"));
+    TH1*   pileup  = dynamic_cast<TH1*>  (file->Get("pileup"));
+    TH1*   weights = dynamic_cast<TH1*>  (file->Get(WeightSummary::histogramName()));
+    if (tree == nullptr || pileup == nullptr || weights == nullptr || pileup->GetNbinsX() != int(result.pileup.size())) return false;
+
+    result = FileResult();
+    if (not result.weights.add(*weights)) return false;
+    for (size_t i = 0; i < result.pileup.size(); i++) result.pileup[i] = pileup->GetBinContent(i+1);
+    result.nEvents = pileup->GetEntries();
+
+    SkimRecord record;
+    forEachColumn(record, [&](const char* name, void* address, const char*) {
+        tree->SetBranchAddress(name, address);
+    });
+    result.records.reserve(tree->GetEntries());
+    for (Long64_t i = 0; i < tree->GetEntries(); i++) {
+        tree->GetEntry(i);
+        result.records.push_back(record);
+    }
+    return true;
+}
+
+void SkimEngine::writeOutput(std::vector<SkimRecord>& records, const SkimSummary& summary, const TH1* puMC) const {
+
+    // The order in which the threads process the input is not fixed
+    std::sort(records.begin(), records.end(), [](const SkimRecord& a, const SkimRecord& b) {
+        if (a.run    != b.run   ) return a.run    < b.run;
+        if (a.lumSec != b.lumSec) return a.lumSec < b.lumSec;
+        return a.event < b.event;
+    });
+
+    // PU and muon ID, isolation scale factor weights, looked up for all the records at once
+    size_t n = records.size();
+    std::vector<float> puweights(n, 1.f);
+    std::vector<float> exweights(n, 1.f);
+    if (config_.isMC) {
+        std::vector<float> putrue(n), eta1(n), pt1(n), eta2(n), pt2(n);
+        for (size_t i = 0; i < n; i++) {
+            putrue[i] = records[i].putrue;
+            eta1[i]   = std::fabs(records[i].m1eta);
+            eta2[i]   = std::fabs(records[i].m2eta);
+            pt1[i]    = std::min(std::max(records[i].m1pt, ScaleFactorTables::muonSFMinPt()), ScaleFactorTables::muonSFMaxPt());
+            pt2[i]    = std::min(std::max(records[i].m2pt, ScaleFactorTables::muonSFMinPt()), ScaleFactorTables::muonSFMaxPt());
+        }
+
+        tables_->puWeights(*puMC).lookup(putrue.data(), n, puweights.data());
+
+        tables_->muonID ().multiply(eta1.data(), pt1.data(), n, exweights.data());
+        tables_->muonID ().multiply(eta2.data(), pt2.data(), n, exweights.data());
+        tables_->muonIso().multiply(eta1.data(), pt1.data(), n, exweights.data());
+        tables_->muonIso().multiply(eta2.data(), pt2.data(), n, exweights.data());
+    }
+
+    std::unique_ptr<TFile> outfile(TFile::Open(config_.outputFile.c_str(), "RECREATE"));
+    if (not outfile || outfile->IsZombie()) throw cms::Exception("SkimEngine") << "Cannot create " << config_.outputFile;
+    TTree* outtree = new TTree("tree", "tree");
+
+    SkimRecord r;
+    double mcweight = 1.0;
+    double puweight = 1.0;
+    double exweight = 1.0;
+
+    outtree->Branch("mcweight" , &mcweight , "mcweight/D" );
+    outtree->Branch("puweight" , &puweight , "puweight/D" );
+    outtree->Branch("exweight" , &exweight , "exweight/D" );
+
+    outtree->Branch("m1pt"     , &r.m1pt   , "m1pt/D"      );
+    outtree->Branch("m1eta"    , &r.m1eta  , "m1eta/D"     );
+    outtree->Branch("m1phi"    , &r.m1phi  , "m1phi/D"     );
+    outtree->Branch("m1id"     , &r.m1id   , "m1id/B"      );
+    outtree->Branch("m2pt"     , &r.m2pt   , "m2pt/D"      );
+    outtree->Branch("m2eta"    , &r.m2eta  , "m2eta/D"     );
+    outtree->Branch("m2phi"    , &r.m2phi  , "m2phi/D"     );
+    outtree->Branch("m2id"     , &r.m2id   , "m2id/B"      );
+    outtree->Branch("mmpt"     , &r.mmpt   , "mmpt/D"      );
+    outtree->Branch("mmeta"    , &r.mmeta  , "mmeta/D"     );
+    outtree->Branch("mmphi"    , &r.mmphi  , "mmphi/D"     );
+    outtree->Branch("mass"     , &r.mass   , "mass/D"      );
+    outtree->Branch("merr"     , &r.merr   , "merr/D"      );
+
+    outtree->Branch("met"      , &r.met    , "met/D"       );
+    outtree->Branch("metphi"   , &r.metphi , "metphi/D"    );
+
+    outtree->Branch("njets"    , &r.njets  , "njets/b"     );
+    outtree->Branch("nbjets"   , &r.nbjets , "nbjets/b"    );
+
+    outtree->Branch("nvtx"     , &r.nvtx   , "nvtx/b"      );
+
+    for (size_t i = 0; i < n; i++) {
+        r = records[i];
+
+        puweight = puweights[i];
+        exweight = exweights[i];
+        mcweight = config_.isMC ? config_.lumi * r.wgt * (config_.xsec >= 0. ? config_.xsec : r.xsec) / summary.wgtsum : 1.0;
+
+        outtree->Fill();
+    }
+
+    outtree->Write();
+    outfile->Close();
+}
+
+void printSkimCutflow(std::ostream& out, const SkimSummary& summary) {
+    out << std::left  << std::setw(16) << "Stage"
+        << std::right << std::setw(6)  << "Cost"
+        << std::setw(14) << "Evaluated"
+        << std::setw(14) << "Passed"
+        << std::setw(10) << "Eff (%)"
+        << std::setw(12) << "Time (ms)"
+        << std::setw(12) << "ns/entry"
+        << std::endl;
+
+    out << std::fixed << std::setprecision(1);
+    for (const SkimStageStats& stage : summary.stages) {
+        out << std::left  << std::setw(16) << stage.name
+            << std::right << std::setw(6)  << stage.cost
+            << std::setw(14) << stage.nEvaluated
+            << std::setw(14) << stage.nPassed
+            << std::setw(10) << (stage.nEvaluated > 0 ? 100.*stage.nPassed/stage.nEvaluated : 0.)
+            << std::setw(12) << stage.seconds*1e3
+            << std::setw(12) << (stage.nEvaluated > 0 ? stage.seconds*1e9/stage.nEvaluated : 0.)
+            << std::endl;
+    }
+    out << std::defaultfloat;
+}
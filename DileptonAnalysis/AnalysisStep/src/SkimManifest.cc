@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+
+#include <TSystem.h>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimManifest.h"
+
+namespace {
+    bool fileStatus(const std::string& path, long long& size, long long& mtime) {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) return false;
+        size  = status.st_size;
+        mtime = status.st_mtime;
+        return true;
+    }
+
+    // Fields of a manifest line, separated by tabs so that the paths may contain spaces
+    std::vector<std::string> splitFields(const std::string& line) {
+        std::vector<std::string> fields;
+        std::string::size_type start = 0;
+        while (true) {
+            std::string::size_type end = line.find('\t', start);
+            fields.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) break;
+            start = end + 1;
+        }
+        return fields;
+    }
+}
+
+SkimManifest::Entry::Entry():
+    size          (-1),
+    mtime         (-1),
+    wgtsumFromTree(false)
+{
+}
+
+SkimManifest::SkimManifest(const std::string& directory, const std::string& fingerprint):
+    directory_  (directory),
+    fingerprint_(fingerprint)
+{
+    gSystem->mkdir(directory_.c_str(), true);
+
+    std::ifstream file(directory_ + "/manifest.txt");
+    std::string line;
+    std::string recorded;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = splitFields(line);
+        if (fields.size() == 2 && fields[0] == "#fingerprint") {
+            recorded = fields[1];
+            continue;
+        }
+        if (fields.size() != 5) continue;
+
+        Entry entry;
+        std::istringstream numbers(fields[0] + " " + fields[1] + " " + fields[2]);
+        if (not (numbers >> entry.size >> entry.mtime >> entry.wgtsumFromTree)) continue;
+        entry.partialFile = fields[3];
+        entry.path        = fields[4];
+        entries_[entry.path] = entry;
+    }
+
+    // The partial outputs were made with another selection or configuration
+    if (recorded != fingerprint_) {
+        for (const auto& entry : entries_) std::remove(entry.second.partialFile.c_str());
+        entries_.clear();
+    }
+}
+
+const SkimManifest::Entry* SkimManifest::find(const std::string& path) const {
+    auto found = entries_.find(path);
+    if (found == entries_.end()) return nullptr;
+
+    long long size, mtime;
+    if (not fileStatus(path, size, mtime)) return nullptr;
+    if (size != found->second.size || mtime != found->second.mtime) return nullptr;
+
+    return &found->second;
+}
+
+bool SkimManifest::makeEntry(const std::string& path, Entry& entry) const {
+    entry = Entry();
+    entry.path = path;
+    if (not fileStatus(path, entry.size, entry.mtime)) return false;
+
+    std::ostringstream name;
+    name << directory_ << "/partial_" << std::hex << std::hash<std::string>()(path) << ".root";
+    entry.partialFile = name.str();
+    return true;
+}
+
+void SkimManifest::update(const Entry& entry) {
+    entries_[entry.path] = entry;
+}
+
+void SkimManifest::retain(const std::vector<std::string>& paths) {
+    std::set<std::string> keep(paths.begin(), paths.end());
+    for (auto entry = entries_.begin(); entry != entries_.end(); ) {
+        if (keep.count(entry->first) > 0) {
+            ++entry;
+            continue;
+        }
+        std::remove(entry->second.partialFile.c_str());
+        entry = entries_.erase(entry);
+    }
+}
+
+void SkimManifest::write() const {
+    std::string filename = directory_ + "/manifest.txt";
+    std::ofstream file(filename);
+    if (not file) throw cms::Exception("SkimManifest") << "Cannot write " << filename;
+
+    file << "#fingerprint\t" << fingerprint_ << "\n";
+    for (const auto& entry : entries_) {
+        file << entry.second.size << "\t" << entry.second.mtime << "\t" << entry.second.wgtsumFromTree << "\t"
+             << entry.second.partialFile << "\t" << entry.second.path << "\n";
+    }
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerMuonMatcher.h"
+
+namespace {
+    // Reorder values in the order given by order, using scratch as buffer
+    void gather(std::vector<float>& values, const std::vector<unsigned>& order, std::vector<float>& scratch) {
+        scratch.resize(order.size());
+        for (size_t i = 0; i < order.size(); i++) scratch[i] = values[order[i]];
+        values.swap(scratch);
+    }
+}
+
+TriggerMuonMatcher::TriggerMuonMatcher(const edm::ParameterSet& iConfig):
+    maxDR_                 (iConfig.existsAs<double>("matchMaxDR")      ? iConfig.getParameter<double>("matchMaxDR")      : 0.1),
+    minPtRatio_            (iConfig.existsAs<double>("matchMinPtRatio") ? iConfig.getParameter<double>("matchMinPtRatio") : 0.5),
+    maxPtRatio_            (iConfig.existsAs<double>("matchMaxPtRatio") ? iConfig.getParameter<double>("matchMaxPtRatio") : 2.0),
+    nEvents_               (0),
+    nTriggerObjects_       (0),
+    nOfflineMuons_         (0),
+    nPairsTested_          (0),
+    nMatchedTriggerObjects_(0),
+    nMatchedOfflineMuons_  (0)
+{
+}
+
+void TriggerMuonMatcher::clearOfflineMuons(size_t n) {
+    relIso_ .clear();
+    idBits_ .clear();
+    muonEta_.clear();
+    muonPhi_.clear();
+    muonPt_ .clear();
+    relIso_ .reserve(n);
+    idBits_ .reserve(n);
+    muonEta_.reserve(n);
+    muonPhi_.reserve(n);
+    muonPt_ .reserve(n);
+}
+
+void TriggerMuonMatcher::addOfflineMuon(const pat::Muon& muon, const reco::Vertex& vertex) {
+    double iso = std::max(0., muon.pfIsolationR04().sumNeutralHadronEt + muon.pfIsolationR04().sumPhotonEt - 0.5*muon.pfIsolationR04().sumPUPt);
+    iso += muon.pfIsolationR04().sumChargedHadronPt;
+    relIso_.push_back(iso/muon.pt());
+
+    unsigned bits = 0;
+    if (muon.isLooseMuon())        bits |= looseID;
+    if (muon.isMediumMuon())       bits |= mediumID;
+    if (muon.isTightMuon(vertex))  bits |= tightID;
+    idBits_.push_back(bits);
+
+    muonEta_.push_back(muon.eta());
+    muonPhi_.push_back(muon.phi());
+    muonPt_ .push_back(muon.pt());
+}
+
+void TriggerMuonMatcher::sortOfflineMuons() {
+    muonIdx_.resize(muonEta_.size());
+    std::iota(muonIdx_.begin(), muonIdx_.end(), 0);
+    std::sort(muonIdx_.begin(), muonIdx_.end(), [this](unsigned a, unsigned b) { return muonEta_[a] < muonEta_[b]; });
+    gather(muonEta_, muonIdx_, scratch_);
+    gather(muonPhi_, muonIdx_, scratch_);
+    gather(muonPt_ , muonIdx_, scratch_);
+}
+
+void TriggerMuonMatcher::setOfflineMuons(const std::vector<pat::Muon>& muons, const reco::Vertex& vertex) {
+    clearOfflineMuons(muons.size());
+    for (const pat::Muon& muon : muons) addOfflineMuon(muon, vertex);
+    sortOfflineMuons();
+}
+
+void TriggerMuonMatcher::setOfflineMuons(const std::vector<pat::MuonRef>& muons, const reco::Vertex& vertex) {
+    clearOfflineMuons(muons.size());
+    for (const pat::MuonRef& muon : muons) addOfflineMuon(*muon, vertex);
+    sortOfflineMuons();
+}
+
+void TriggerMuonMatcher::match(const TriggerObjectIndex& triggerObjects) {
+    size_t nmu  = muonEta_.size();
+    size_t ntrg = triggerObjects.size();
+
+    // Trigger objects sorted in eta
+    trgIdx_.resize(ntrg);
+    std::iota(trgIdx_.begin(), trgIdx_.end(), 0);
+    std::sort(trgIdx_.begin(), trgIdx_.end(), [&triggerObjects](unsigned a, unsigned b) { return triggerObjects.object(a).eta() < triggerObjects.object(b).eta(); });
+    trgEta_.resize(ntrg);
+    trgPhi_.resize(ntrg);
+    trgPt_ .resize(ntrg);
+    for (size_t i = 0; i < ntrg; i++) {
+        const pat::TriggerObjectStandAlone& object = triggerObjects.object(trgIdx_[i]);
+        trgEta_[i] = object.eta();
+        trgPhi_[i] = object.phi();
+        trgPt_ [i] = object.pt();
+    }
+
+    offlineMatch_   .assign(ntrg, -1);
+    triggerMatch_   .assign(nmu , -1);
+    matchedPathBits_.assign(nmu ,  0);
+    offlineMatchDR2_.assign(ntrg, std::numeric_limits<float>::max());
+    triggerMatchDR2_.assign(nmu , std::numeric_limits<float>::max());
+
+    // Sweep over the trigger objects in eta, first is the first muon that can still be within maxDR_ in eta
+    float  maxDR2 = maxDR_*maxDR_;
+    size_t first  = 0;
+    for (size_t i = 0; i < ntrg; i++) {
+        while (first < nmu && muonEta_[first] < trgEta_[i] - maxDR_) first++;
+        for (size_t j = first; j < nmu && muonEta_[j] <= trgEta_[i] + maxDR_; j++) {
+            nPairsTested_++;
+
+            float dR2 = reco::deltaR2(trgEta_[i], trgPhi_[i], muonEta_[j], muonPhi_[j]);
+            if (dR2 > maxDR2) continue;
+            float ratio = trgPt_[i]/muonPt_[j];
+            if (minPtRatio_ >= 0. && ratio < minPtRatio_) continue;
+            if (maxPtRatio_ >= 0. && ratio > maxPtRatio_) continue;
+
+            unsigned itrg = trgIdx_[i];
+            unsigned imu  = muonIdx_[j];
+            matchedPathBits_[imu] |= triggerObjects.pathBits(itrg);
+            if (dR2 < offlineMatchDR2_[itrg]) {
+                offlineMatchDR2_[itrg] = dR2;
+                offlineMatch_   [itrg] = imu;
+            }
+            if (dR2 < triggerMatchDR2_[imu]) {
+                triggerMatchDR2_[imu] = dR2;
+                triggerMatch_   [imu] = itrg;
+            }
+        }
+    }
+
+    nEvents_++;
+    nTriggerObjects_        += ntrg;
+    nOfflineMuons_          += nmu;
+    nMatchedTriggerObjects_ += std::count_if(offlineMatch_.begin(), offlineMatch_.end(), [](int imu)  { return imu  >= 0; });
+    nMatchedOfflineMuons_   += std::count_if(triggerMatch_.begin(), triggerMatch_.end(), [](int itrg) { return itrg >= 0; });
+}
+
+void TriggerMuonMatcher::report(const std::string& category) const {
+    edm::LogInfo(category) << "Trigger object matching over " << nEvents_ << " events : "
+                           << nMatchedTriggerObjects_ << " of " << nTriggerObjects_ << " trigger objects and "
+                           << nMatchedOfflineMuons_ << " of " << nOfflineMuons_ << " offline muons matched, "
+                           << nPairsTested_ << " pairs tested";
+}
@@ -0,0 +1,85 @@
+#include <cctype>
+
+#include "FWCore/Common/interface/TriggerNames.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/TriggerObjectIndex.h"
+
+namespace {
+    // Path name without its version suffix, "HLT_IsoMu24" for "HLT_IsoMu24", "HLT_IsoMu24_v" or "HLT_IsoMu24_v*"
+    std::string unversionedPath(std::string path) {
+        if (not path.empty() && path.back() == '*') path.pop_back();
+        if (path.size() > 2 && path.compare(path.size()-2, 2, "_v") == 0) path.resize(path.size()-2);
+        return path;
+    }
+
+    // Whether menuPath is path itself or one of its versions, path_v<digits>, as hasPathName("path_v*") in the MiniAOD objects
+    bool isPathVersion(const std::string& menuPath, const std::string& path) {
+        if (menuPath.compare(0, path.size(), path) != 0) return false;
+        if (menuPath.size() == path.size()) return true;
+        if (menuPath.size() < path.size() + 3 || menuPath.compare(path.size(), 2, "_v") != 0) return false;
+        for (size_t i = path.size() + 2; i < menuPath.size(); i++) {
+            if (not std::isdigit((unsigned char)menuPath[i])) return false;
+        }
+        return true;
+    }
+}
+
+TriggerObjectIndex::TriggerObjectIndex(const std::vector<std::string>& collections, const std::vector<std::string>& paths):
+    collections_(collections)
+{
+    if (paths.size() > 32) throw cms::Exception("TriggerObjectIndex") << paths.size() << " paths given, at most 32 can be indexed";
+    for (const std::string& path : paths) paths_.push_back(unversionedPath(path));
+}
+
+void TriggerObjectIndex::beginRun(const std::vector<std::string>& menuPaths) {
+    menuPathBits_.clear();
+    for (const std::string& menuPath : menuPaths) {
+        unsigned bits = 0;
+        for (size_t i = 0; i < paths_.size(); i++) {
+            if (isPathVersion(menuPath, paths_[i])) bits |= pathBit(i);
+        }
+        if (bits != 0) menuPathBits_[menuPath] = bits;
+    }
+}
+
+int TriggerObjectIndex::findCollection(const std::string& collection) const {
+    if (collections_.empty()) return 0;
+    std::string label = collection.substr(0, collection.find("::"));
+    for (size_t i = 0; i < collections_.size(); i++) {
+        if (label == collections_[i]) return i;
+    }
+    return -1;
+}
+
+void TriggerObjectIndex::fill(const pat::TriggerObjectStandAloneCollection& objects, const edm::TriggerNames& triggerNames) {
+    objects_      .clear();
+    collectionIdx_.clear();
+    pathBits_     .clear();
+
+    const std::string* lastCollection = nullptr;
+    int                lastIdx        = -1;
+    for (const pat::TriggerObjectStandAlone& object : objects) {
+        if (lastCollection == nullptr || object.collection() != *lastCollection) {
+            lastCollection = &object.collection();
+            lastIdx        = findCollection(object.collection());
+        }
+        if (lastIdx < 0) continue;
+
+        unsigned bits = 0;
+        if (not menuPathBits_.empty()) {
+            // The event product is const, and the packed path indices have no public accessor :
+            // the object is unpacked in a copy, assigned to scratch_ to reuse its buffers
+            scratch_ = object;
+            scratch_.unpackPathNames(triggerNames);
+            for (const std::string& path : scratch_.pathNames(true, false)) {
+                auto found = menuPathBits_.find(path);
+                if (found != menuPathBits_.end()) bits |= found->second;
+            }
+        }
+
+        objects_      .push_back(&object);
+        collectionIdx_.push_back(lastIdx);
+        pathBits_     .push_back(bits);
+    }
+}
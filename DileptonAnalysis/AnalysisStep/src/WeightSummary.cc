@@ -0,0 +1,61 @@
+#include <memory>
+
+#include <TFile.h>
+#include <TH1.h>
+
+#include "DileptonAnalysis/AnalysisStep/interface/WeightSummary.h"
+
+WeightSummary::WeightSummary():
+    nEvents_  (0),
+    nNegative_(0),
+    sumw_     (0.0),
+    sumw2_    (0.0)
+{
+}
+
+void WeightSummary::add(const WeightSummary& other) {
+    nEvents_   += other.nEvents_;
+    nNegative_ += other.nNegative_;
+    sumw_      += other.sumw_;
+    sumw2_     += other.sumw2_;
+}
+
+void WeightSummary::setupHistogram(TH1& hist) {
+    hist.SetBins(nBins, 0., nBins);
+    hist.GetXaxis()->SetBinLabel(nEventsBin  , "nevents");
+    hist.GetXaxis()->SetBinLabel(sumwBin     , "sumw"   );
+    hist.GetXaxis()->SetBinLabel(sumw2Bin    , "sumw2"  );
+    hist.GetXaxis()->SetBinLabel(nNegativeBin, "nneg"   );
+}
+
+void WeightSummary::write(TH1& hist) const {
+    hist.SetBinContent(nEventsBin  , nEvents_  );
+    hist.SetBinContent(sumwBin     , sumw_     );
+    hist.SetBinContent(sumw2Bin    , sumw2_    );
+    hist.SetBinContent(nNegativeBin, nNegative_);
+
+    // SetBinContent leaves the entries unset, hadd and the IsEmpty() checks would then skip the summary
+    hist.SetEntries(nEvents_);
+}
+
+bool WeightSummary::add(const TH1& hist) {
+    if (hist.GetNbinsX() != nBins) return false;
+    nEvents_   += (unsigned long long)hist.GetBinContent(nEventsBin  );
+    sumw_      +=                     hist.GetBinContent(sumwBin     );
+    sumw2_     +=                     hist.GetBinContent(sumw2Bin    );
+    nNegative_ += (unsigned long long)hist.GetBinContent(nNegativeBin);
+    return true;
+}
+
+bool WeightSummary::add(const std::vector<std::string>& files, const std::string& dir) {
+    WeightSummary total;
+    std::string histpath = dir + "/" + histogramName();
+    for (const std::string& filename : files) {
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str()));
+        if (not file || file->IsZombie()) return false;
+        TH1* hist = dynamic_cast<TH1*>(file->Get(histpath.c_str()));
+        if (hist == nullptr || not total.add(*hist)) return false;
+    }
+    add(total);
+    return true;
+}
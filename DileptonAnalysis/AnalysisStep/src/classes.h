@@ -0,0 +1,3 @@
+#include "DataFormats/Common/interface/Wrapper.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/GenParticleSummary.h"
@@ -138,6 +138,13 @@ params.register(
     'Process name for the MET filter paths'
 )
 
+params.register(
+    'debugTraceEvery', 
+    0, 
+    VarParsing.multiplicity.singleton,VarParsing.varType.int,
+    'Print the debug trace of the treemaker every N events (0 to disable, needs a build with -DDILEPTON_DEBUG_TRACE)'
+)
+
 params.register(
     'GlobalTagMC',
     '102X_upgrade2018_realistic_v18',  
@@ -163,6 +170,11 @@ process.load("FWCore.MessageService.MessageLogger_cfi")
 process.MessageLogger.destinations = ['cout', 'cerr']
 process.MessageLogger.cerr.FwkReport.reportEvery = 100
 
+# Categories used by the treemaker instrumentation and debug printouts
+for category in ['AllocationMonitor', 'L1TableDump', 'LHEWeightsTreeMaker', 'TreeMaker', 'TreeMakerVertex']:
+    process.MessageLogger.categories.append(category)
+    setattr(process.MessageLogger.cerr, category, cms.untracked.PSet(limit = cms.untracked.int32(-1)))
+
 # Set the process options -- Display summary at the end, enable unscheduled execution
 process.options = cms.untracked.PSet( 
     allowUnscheduled = cms.untracked.bool(True),
@@ -236,7 +248,15 @@ process.gentree = cms.EDAnalyzer("LHEWeightsTreeMaker",
     lheInfo = cms.InputTag("externalLHEProducer"),
     genInfo = cms.InputTag("generator"),
     useLHEWeights = cms.bool(params.useWeights),
-    pileupinfo = cms.InputTag("addPileupInfo")
+    pileupinfo = cms.InputTag("addPileupInfo"),
+    # One entry per lumi block (gentree/lumis) instead of one per event (gentree/tree)
+    aggregateLumis = cms.bool(False),
+    storeLHEWeightSums = cms.bool(False),
+    # LHE scale/PDF weights normalized to the nominal one, stored per event in half precision
+    lheRunInfo = cms.InputTag("externalLHEProducer"),
+    storeLHEWeights = cms.bool(False),
+    # IDs of the LHE weights to keep, all of them if empty
+    lheWeightIDs = cms.vstring()
 )
 
 # Select good primary vertices
@@ -344,6 +364,25 @@ process.mmtree = cms.EDAnalyzer('TreeMaker',
     useMediumID2016   = cms.bool(params.useMediumID2016),
     addEventInfo      = cms.bool(params.addEventInfo),
     filterHToMuMu     = cms.bool(params.filterHToMuMu),
+    dumpL1Table       = cms.bool(False),
+    debugTraceEvery   = cms.uint32(params.debugTraceEvery),
+    # Preselection of the muon pairs given to the vertex fit (negative values disable a cut, 0 fits all pairs)
+    requireOppositeCharge = cms.bool(False),
+    minPairDR         = cms.double(-1.),
+    maxPairDR         = cms.double(-1.),
+    minPairMass       = cms.double(-1.),
+    maxPairMass       = cms.double(-1.),
+    maxFittedPairs    = cms.uint32(0),
+    # Distance of closest approach (cm) above which a pair is not fitted (negative to disable)
+    maxPairDCA        = cms.double(-1.),
+    # HLT paths whose trigger objects are matched to the muons (mhlt branch), empty to disable
+    hltMatchPaths     = cms.vstring(),
+    hltMatchCollections = cms.vstring(),
+    matchMaxDR        = cms.double(0.1),
+    matchMinPtRatio   = cms.double(0.5),
+    matchMaxPtRatio   = cms.double(2.0),
+    # MET columns to store: raw, type1 (t1met, t1metphi, read by the skim), and the type-1 shifts jec, jer, unclustered
+    metColumns        = cms.vstring('type1'),
 	xsec              = cms.double(params.xsec),
     triggerresults    = cms.InputTag("TriggerResults", "", params.trigProcess),
     filterresults     = cms.InputTag("TriggerResults", "", params.miniAODProcess),
@@ -369,13 +408,16 @@ process.mmtree = cms.EDAnalyzer('TreeMaker',
     pileupinfo        = cms.InputTag("slimmedAddPileupInfo"),
     geneventinfo      = cms.InputTag("generator"),
     genlumiheader     = cms.InputTag("generator"),
-    gens              = cms.InputTag("prunedGenParticles"),
+    genSummary        = cms.InputTag("genParticleSummary"),
     beamSpot=cms.InputTag("offlineBeamSpot")
 )
 
+# GEN particles of the tree
+process.load("DileptonAnalysis.AnalysisStep.GenParticleSummary_cfi")
+
 # Analysis path
 if params.isMC : 
-    process.p = cms.Path(process.gentree + process.metfilters + process.mmtree)
+    process.p = cms.Path(process.gentree + process.metfilters + process.genParticleSummary + process.mmtree)
 else : 
     process.p = cms.Path(                  process.metfilters + process.mmtree)
 
@@ -8,6 +8,7 @@ import time
 from time import gmtime, strftime
 import math
 from array import array
+from DileptonAnalysis.AnalysisStep.TriggerPaths_2017_cfi import getL1Conf
 
 #define function for parsing options
 def parseOptions():
@@ -50,6 +51,10 @@ def injson(run, LS):
       if (LS>=L1_12_5_on[run][i][0] and LS<=L1_12_5_on[run][i][1]): return True
   return False
 
+# The treemaker packs the L1 seed decisions in the l1Bits branch, bit i being the i-th seed of getL1Conf()
+def l1Fired(bits, iseed):
+  return ((bits >> iseed) & 1) == 1
+
 def fillTree():
 
   global opt, args
@@ -325,24 +330,24 @@ def fillTree():
     pass157[0] = 0
     passDouble4p5mass[0] = 0
     passDouble4dR[0] = 0
-    if (t.l1Result[0]): 
+    if (l1Fired(t.l1Bits,0)): 
       passNumTrig[0] = 1
       pass125[0] = 1
-    if (t.l1Result[4]): 
+    if (l1Fired(t.l1Bits,4)): 
       passNumTrig[0] = 1
       pass157[0] = 1
-    if (t.l1Result[11]): 
+    if (l1Fired(t.l1Bits,11)): 
       passNumTrig[0] = 1
       passDouble4p5mass[0] = 1
-    if (t.l1Result[12]): 
+    if (l1Fired(t.l1Bits,12)): 
       passNumTrig[0] = 1
       passDouble4dR[0] = 1
 
-    #if (t.l1Result[4]): passNumTrig[0] = 1
-    #if (t.l1Result[12]): passNumTrig[0] = 1
+    #if (l1Fired(t.l1Bits,4)): passNumTrig[0] = 1
+    #if (l1Fired(t.l1Bits,12)): passNumTrig[0] = 1
 
     # for making eff. w.r.t. prescaled L1 trigger L1_DoubleMu0_SQ
-    if (t.l1Result[len(t.l1Result)-1]): passDenTrig[0] = 1
+    if (l1Fired(t.l1Bits,len(getL1Conf())-1)): passDenTrig[0] = 1
     else: passDenTrig[0] = 0
 
     # check HLT is passed
@@ -0,0 +1,61 @@
+import FWCore.ParameterSet.Config as cms
+
+# Throughput of HLTCheckFilter alone, e.g.
+#     cmsRun hltcheck_cfg.py inputFiles=file:miniaod.root maxEvents=100000 nThreads=8
+# The Timing service prints the event throughput at the end of the job
+from FWCore.ParameterSet.VarParsing import VarParsing
+params = VarParsing('analysis')
+
+params.register(
+    'nThreads',
+    8,
+    VarParsing.multiplicity.singleton,VarParsing.varType.int,
+    'Number of threads and streams'
+)
+
+params.register(
+    'trigProcess',
+    'HLT',
+    VarParsing.multiplicity.singleton,VarParsing.varType.string,
+    'Process name of the HLT trigger results'
+)
+
+# Define the process
+process = cms.Process("HLTCheck")
+
+# Parse command line arguments
+params.parseArguments()
+
+# Message Logger settings
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 10000
+
+process.options = cms.untracked.PSet(
+    numberOfThreads  = cms.untracked.uint32(params.nThreads),
+    numberOfStreams  = cms.untracked.uint32(params.nThreads),
+    wantSummary      = cms.untracked.bool(True)
+)
+
+process.Timing = cms.Service("Timing",
+    summaryOnly = cms.untracked.bool(True)
+)
+
+# How many events to process
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(params.maxEvents) )
+
+# Input EDM files
+process.source = cms.Source("PoolSource",
+    fileNames = cms.untracked.vstring(params.inputFiles)
+)
+
+process.hltcheck = cms.EDFilter("HLTCheckFilter",
+    triggerResults = cms.InputTag("TriggerResults", "", params.trigProcess),
+    triggerPaths   = cms.vstring(
+        "HLT_IsoMu24_v",
+        "HLT_IsoTkMu24_v",
+        "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_v",
+        "HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_v"
+    )
+)
+
+process.p = cms.Path(process.hltcheck)
@@ -0,0 +1,142 @@
+// Skim of a tiny mmtree/tree written on the fly, see interface/SkimEngine.h
+//
+// The fixture has four data events with two muons each :
+//     - both muons pass the medium ID, opposite sign, the first one trigger matched : selected
+//     - same sign muons                                                              : rejected
+//     - neither muon trigger matched                                                 : rejected
+//     - only the second muon trigger matched                                         : selected
+// A second fixture without the t1met/t1metphi columns has to be rejected with an exception.
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TLorentzVector.h>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DileptonAnalysis/AnalysisStep/interface/SkimEngine.h"
+
+namespace {
+    struct FixtureEvent {
+        int      charge1, charge2;
+        unsigned hlt1, hlt2;
+    };
+
+    void writeFixture(const std::string& filename, bool withMET) {
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "RECREATE"));
+        file->mkdir("mmtree")->cd();
+        TTree* tree = new TTree("tree", "tree");
+
+        unsigned                    run = 1, lumSec = 1, event = 0;
+        double                      xsec = 1., wgt = 1., t1met = 20., t1metphi = 0.5;
+        unsigned char               nvtx = 20, putrue = 20, hltsinglemu = 1;
+        std::vector<TLorentzVector> muons(2), jets;
+        std::vector<int>            mid(2);
+        std::vector<bool>           midmedium(2, true);
+        std::vector<double>         miso(2, 0.05), masserr(1, 0.5), pairVtxProb(1, 0.9), jbtag;
+        std::vector<unsigned>       mhlt(2);
+        std::vector<unsigned char>  m1idx(1, 0), m2idx(1, 1);
+        std::vector<char>           jid;
+
+        tree->Branch("run"        , &run        , "run/i"        );
+        tree->Branch("lumSec"     , &lumSec     , "lumSec/i"     );
+        tree->Branch("event"      , &event      , "event/i"      );
+        tree->Branch("xsec"       , &xsec       , "xsec/D"       );
+        tree->Branch("wgt"        , &wgt        , "wgt/D"        );
+        tree->Branch("nvtx"       , &nvtx       , "nvtx/b"       );
+        tree->Branch("putrue"     , &putrue     , "putrue/b"     );
+        tree->Branch("hltsinglemu", &hltsinglemu, "hltsinglemu/b");
+        tree->Branch("muons"      , "std::vector<TLorentzVector>", &muons      , 32000, 0);
+        tree->Branch("mid"        , "std::vector<int>"           , &mid        );
+        tree->Branch("midmedium"  , "std::vector<bool>"          , &midmedium  );
+        tree->Branch("miso"       , "std::vector<double>"        , &miso       );
+        tree->Branch("mhlt"       , "std::vector<unsigned>"      , &mhlt       );
+        tree->Branch("m1idx"      , "std::vector<unsigned char>" , &m1idx      );
+        tree->Branch("m2idx"      , "std::vector<unsigned char>" , &m2idx      );
+        tree->Branch("masserr"    , "std::vector<double>"        , &masserr    );
+        tree->Branch("pairVtxProb", "std::vector<double>"        , &pairVtxProb);
+        tree->Branch("jets"       , "std::vector<TLorentzVector>", &jets       , 32000, 0);
+        tree->Branch("jbtag"      , "std::vector<double>"        , &jbtag      );
+        tree->Branch("jid"        , "std::vector<char>"          , &jid        );
+        if (withMET) {
+        tree->Branch("t1met"      , &t1met      , "t1met/D"      );
+        tree->Branch("t1metphi"   , &t1metphi   , "t1metphi/D"   );
+        }
+
+        const FixtureEvent events[] = {
+            {+1, -1, 1, 0},
+            {+1, +1, 1, 1},
+            {+1, -1, 0, 0},
+            {-1, +1, 0, 1}
+        };
+        for (const FixtureEvent& e : events) {
+            event++;
+            muons[0].SetPtEtaPhiM(45., 0.3,  0.2, 0.1057);
+            muons[1].SetPtEtaPhiM(40., -0.5, 2.9, 0.1057);
+            mid[0]  = -13 * e.charge1;
+            mid[1]  = -13 * e.charge2;
+            mhlt[0] = e.hlt1;
+            mhlt[1] = e.hlt2;
+            tree->Fill();
+        }
+
+        file->Write();
+        file->Close();
+    }
+}
+
+int main() {
+    const std::string input   = "testSkimEngine_input.root";
+    const std::string noMET   = "testSkimEngine_noMET.root";
+    const std::string output  = "testSkimEngine_output.root";
+    int status = 0;
+
+    writeFixture(input, true);
+    writeFixture(noMET, false);
+
+    SkimConfig config;
+    config.isMC       = false;
+    config.nThreads   = 1;
+    config.inputFiles = input;
+    config.outputFile = output;
+
+    try {
+        SkimEngine engine(config);
+        SkimSummary summary = engine.run();
+        if (summary.nEvents != 4 || summary.nSelected != 2) {
+            std::cerr << "testSkimEngine : " << summary.nSelected << " of " << summary.nEvents << " events selected, expected 2 of 4" << std::endl;
+            status = 1;
+        }
+
+        std::unique_ptr<TFile> file(TFile::Open(output.c_str()));
+        TTree* tree = file ? dynamic_cast<TTree*>(file->Get("tree")) : nullptr;
+        if (tree == nullptr || tree->GetEntries() != 2) {
+            std::cerr << "testSkimEngine : the output tree does not have the 2 selected events" << std::endl;
+            status = 1;
+        }
+    }
+    catch (const cms::Exception& e) {
+        std::cerr << "testSkimEngine : " << e.what() << std::endl;
+        status = 1;
+    }
+
+    config.inputFiles = noMET;
+    try {
+        SkimEngine engine(config);
+        engine.run();
+        std::cerr << "testSkimEngine : no exception for an input without t1met" << std::endl;
+        status = 1;
+    }
+    catch (const cms::Exception&) {
+    }
+
+    std::remove(input .c_str());
+    std::remove(noMET .c_str());
+    std::remove(output.c_str());
+    return status;
+}
@@ -1,14 +1,266 @@
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <sstream>
+#include <unordered_set>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
 #include "GeneratorInterface/Core/interface/GeneratorFilter.h"
 #include "GeneratorInterface/ExternalDecays/interface/ExternalDecayDriver.h"
 #include "GeneratorInterface/Pythia8Interface/interface/Py8GunBase.h"
 namespace gen {
+// Table of the generated records (events) of the input file
+//
+// Each record is a list of particles with their PDG ID, status and (E, px, py, pz). They are held
+// as packed columns, one entry per particle of all the records, with the particles of the record
+// r at the positions offset(r) ... offset(r+1)-1. The input is either
+//  - a text file of whitespace separated rows "record pdgId status E px py pz", one per particle,
+//    the consecutive rows with the same record number making a record,
+//  - the original text file of "E px py pz" rows, in records of a fixed number of rows whose PDG
+//    IDs and status are given by the row layout,
+//  - or the binary table made from one of them by csvToBinaryTable.py.
+// The text files are parsed into memory. The binary table is memory-mapped read-only and accessed in
+// place : opening it costs nothing whatever its size, and the pages are shared by all the generator
+// jobs reading the same file on a node. It is made of native (little-endian) values
+//    char     magic[8]  "PY8GUNTB"
+//    uint32_t version   2
+//    uint32_t reserved  0
+//    uint64_t nRecords
+//    uint64_t nParticles
+//    uint64_t offset[nRecords+1]
+//    int32_t  pdgId[nParticles], status[nParticles]
+//    float    E[nParticles], px[nParticles], py[nParticles], pz[nParticles]
+struct Py8GunRowLayout {
+   std::vector<int> pdgIds; // of each row of a record, 0 if unknown
+   std::vector<int> status;
+};
+class Py8GunTable {
+   
+   public:
+      
+      static const char     kMagic[8];
+      static const uint32_t kVersion = 2;
+      
+      Py8GunTable( std::string const& filename, Py8GunRowLayout const& layout );
+      ~Py8GunTable();
+      Py8GunTable( Py8GunTable const& ) = delete;
+      Py8GunTable& operator=( Py8GunTable const& ) = delete;
+      
+      size_t size() const { return fNRecords; }
+      size_t nParticles() const { return fNParticles; }
+      bool   mapped() const { return fMap != nullptr; }
+      // particles of the record r
+      uint64_t begin( size_t r ) const { return fOffsets[r]; }
+      uint64_t end( size_t r ) const { return fOffsets[r+1]; }
+      // particle i
+      int   pdgId( size_t i ) const { return fPdgId[i]; }
+      int   status( size_t i ) const { return fStatus[i]; }
+      float e( size_t i ) const { return fE[i]; }
+      float px( size_t i ) const { return fPx[i]; }
+      float py( size_t i ) const { return fPy[i]; }
+      float pz( size_t i ) const { return fPz[i]; }
+      
+   private:
+      
+      struct Header {
+         char     magic[8];
+         uint32_t version;
+         uint32_t reserved;
+         uint64_t nRecords;
+         uint64_t nParticles;
+      };
+      
+      bool mapBinary( std::string const& filename );
+      void readText( std::string const& filename, Py8GunRowLayout const& layout );
+      void appendParticle( int pdgId, int status, float ee, float px, float py, float pz );
+      
+      void*           fMap;
+      size_t          fMapSize;
+      size_t          fNRecords, fNParticles;
+      const uint64_t* fOffsets;
+      const int32_t*  fPdgId;
+      const int32_t*  fStatus;
+      const float    *fE, *fPx, *fPy, *fPz;
+      
+      // storage of the columns read from a text file
+      std::vector<uint64_t> fTextOffsets;
+      std::vector<int32_t>  fTextPdgId, fTextStatus;
+      std::vector<float>    fTextE, fTextPx, fTextPy, fTextPz;
+};
+const char Py8GunTable::kMagic[8] = {'P','Y','8','G','U','N','T','B'};
+const uint32_t Py8GunTable::kVersion;
+Py8GunTable::Py8GunTable( std::string const& filename, Py8GunRowLayout const& layout )
+   : fMap(nullptr), fMapSize(0), fNRecords(0), fNParticles(0) {
+   if ( mapBinary(filename) ) return;
+   readText(filename, layout);
+}
+Py8GunTable::~Py8GunTable() {
+   if ( fMap ) munmap(fMap, fMapSize);
+}
+bool Py8GunTable::mapBinary( std::string const& filename ) {
+   int fd = open(filename.c_str(), O_RDONLY);
+   if ( fd < 0 ) throw cms::Exception("Configuration") << "Py8CSVReaderGun: cannot open " << filename;
+   struct stat status;
+   Header header;
+   bool binary = fstat(fd, &status) == 0 && (size_t)status.st_size >= sizeof(Header)
+              && pread(fd, &header, sizeof(Header), 0) == (ssize_t)sizeof(Header)
+              && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0;
+   if ( !binary ) {
+      close(fd);
+      return false;
+   }
+   size_t expectedSize = sizeof(Header) + (header.nRecords + 1) * sizeof(uint64_t)
+                       + header.nParticles * (2*sizeof(int32_t) + 4*sizeof(float));
+   if ( header.version != kVersion || (size_t)status.st_size != expectedSize ) {
+      close(fd);
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: " << filename << " is not a valid version "
+                                            << kVersion << " binary table (version " << header.version << ", "
+                                            << header.nRecords << " records, " << header.nParticles << " particles, "
+                                            << status.st_size << " bytes), remake it with csvToBinaryTable.py";
+   }
+   fMapSize = status.st_size;
+   fMap = mmap(nullptr, fMapSize, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( fMap == MAP_FAILED ) {
+      fMap = nullptr;
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: cannot map " << filename;
+   }
+   // the events are drawn at random
+   madvise(fMap, fMapSize, MADV_RANDOM);
+   fNRecords   = header.nRecords;
+   fNParticles = header.nParticles;
+   const char* data = static_cast<const char*>(fMap) + sizeof(Header);
+   fOffsets = reinterpret_cast<const uint64_t*>(data);
+   fPdgId   = reinterpret_cast<const int32_t*>(fOffsets + fNRecords + 1);
+   fStatus  = fPdgId + fNParticles;
+   fE  = reinterpret_cast<const float*>(fStatus + fNParticles);
+   fPx = fE  + fNParticles;
+   fPy = fPx + fNParticles;
+   fPz = fPy + fNParticles;
+   if ( fOffsets[0] != 0 || fOffsets[fNRecords] != fNParticles )
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: inconsistent record offsets in " << filename;
+   return true;
+}
+void Py8GunTable::appendParticle( int pdgId, int status, float ee, float px, float py, float pz ) {
+   fTextPdgId.push_back(pdgId);
+   fTextStatus.push_back(status);
+   fTextE.push_back(ee);
+   fTextPx.push_back(px);
+   fTextPy.push_back(py);
+   fTextPz.push_back(pz);
+}
+void Py8GunTable::readText( std::string const& filename, Py8GunRowLayout const& layout ) {
+   std::ifstream infile(filename);
+   // the number of columns of the first row tells the format
+   std::string line;
+   while ( std::getline(infile, line) && line.find_first_not_of(" \t\r") == std::string::npos ) {}
+   std::istringstream firstRow(line);
+   std::string field;
+   unsigned nColumns = 0;
+   while ( firstRow >> field ) nColumns++;
+   infile.clear();
+   infile.seekg(0);
+   
+   fTextOffsets.push_back(0);
+   if ( nColumns == 7 ) {
+      long record, lastRecord = 0;
+      int pdgId, status;
+      float ee, px, py, pz;
+      while (infile >> record >> pdgId >> status >> ee >> px >> py >> pz) {
+         if ( !fTextPdgId.empty() && record != lastRecord ) fTextOffsets.push_back(fTextPdgId.size());
+         lastRecord = record;
+         appendParticle(pdgId, status, ee, px, py, pz);
+      }
+      if ( !fTextPdgId.empty() ) fTextOffsets.push_back(fTextPdgId.size());
+   }
+   else if ( nColumns == 4 ) {
+      size_t nRows = layout.pdgIds.size();
+      float ee, px, py, pz;
+      while (infile >> ee >> px >> py >> pz) {
+         size_t row = fTextPdgId.size() % nRows;
+         appendParticle(layout.pdgIds[row], layout.status[row], ee, px, py, pz);
+         if ( row == nRows-1 ) fTextOffsets.push_back(fTextPdgId.size());
+      }
+      if ( fTextPdgId.size() % nRows != 0 )
+         edm::LogWarning("Py8CSVReaderGun") << "Ignoring the last " << fTextPdgId.size() % nRows << " rows of "
+                                            << filename << ", not a complete record";
+   }
+   else if ( nColumns != 0 ) {
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: " << filename << " has rows of " << nColumns
+                                            << " columns, expected 4 (E px py pz) or 7 (record pdgId status E px py pz)";
+   }
+   infile.close();
+   fNRecords   = fTextOffsets.size() - 1;
+   fNParticles = fTextOffsets.back();
+   fOffsets = fTextOffsets.data();
+   fPdgId   = fTextPdgId.data();
+   fStatus  = fTextStatus.data();
+   fE  = fTextE.data();
+   fPx = fTextPx.data();
+   fPy = fTextPy.data();
+   fPz = fTextPz.data();
+}
+// Seeded random permutation of 0 ... n-1, evaluated one element at a time
+//
+// A 4-round Feistel network is a bijection of the 2k-bit integers for any round function;
+// with 4^k the smallest such domain not below n, cycle-walking (re-applying it until the
+// result falls below n) gives a bijection of 0 ... n-1. It needs no memory and, as the domain
+// is less than 4n, less than 4 iterations on average per element.
+class Py8GunPermutation {
+   
+   public:
+      
+      Py8GunPermutation( uint64_t n, uint64_t seed );
+      uint64_t size() const { return fN; }
+      uint64_t operator()( uint64_t i ) const;
+      
+   private:
+      
+      static uint64_t mix( uint64_t x );
+      
+      uint64_t fN;
+      unsigned fHalfBits;
+      uint64_t fHalfMask;
+      uint64_t fKeys[4];
+};
+Py8GunPermutation::Py8GunPermutation( uint64_t n, uint64_t seed )
+   : fN(n), fHalfBits(1) {
+   while ( fHalfBits < 32 && (uint64_t(1) << (2*fHalfBits)) < n ) fHalfBits++;
+   fHalfMask = (uint64_t(1) << fHalfBits) - 1;
+   for ( int r = 0; r < 4; r++ ) fKeys[r] = mix(seed + 0x9e3779b97f4a7c15ULL * (r+1));
+}
+// splitmix64 finalizer
+uint64_t Py8GunPermutation::mix( uint64_t x ) {
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+uint64_t Py8GunPermutation::operator()( uint64_t i ) const {
+   uint64_t x = i;
+   do {
+      uint64_t left  = x >> fHalfBits;
+      uint64_t right = x & fHalfMask;
+      for ( int r = 0; r < 4; r++ ) {
+         uint64_t next = left ^ (mix(right ^ fKeys[r]) & fHalfMask);
+         left  = right;
+         right = next;
+      }
+      x = (left << fHalfBits) | right;
+   } while ( x >= fN );
+   return x;
+}
 class Py8CSVReaderGun : public Py8GunBase {
    
    public:
       
       Py8CSVReaderGun( edm::ParameterSet const& );
-      ~Py8CSVReaderGun() override {}
+      ~Py8CSVReaderGun() override;
       bool generatePartonsAndHadronize() override;
       const char* classname() const override;
 	 
@@ -22,15 +274,36 @@ class Py8CSVReaderGun : public Py8GunBase {
       double  fMinProdRadius;
       double  fMaxProdRadius;
       bool    fMakeDisplaced;
-      int     fNumParticlesPerEvent; // number of particles saved in each event
+      int     fNumParticlesPerEvent; // number of particles saved in each event (E px py pz input)
       std::string fFilename;
-      std::vector<float> all_ee, all_px, all_py, all_pz;
-      std::vector<int> used_events;
+      std::unique_ptr<Py8GunTable> fTable;
+      uint64_t fNEvents; // number of records in the table
+      
+      // particles of a record given to Pythia: PDG IDs (any if empty) and status
+      std::vector<int> fInjectPdgIds;
+      std::vector<int> fInjectStatus;
+      
+      // logging: 0 = setup and periodic summaries, 1 = also each generated event
+      int      fVerbosity;
+      unsigned fSummaryInterval; // events between two summaries, 0 for none
+      uint64_t fNGenerated, fNRepeated;
+      
+      // event sampling: "random" draws with rejection of the records already used (up to 100 tries),
+      // "permutation" walks this job's share of a seeded permutation of the records
+      bool     fUsePermutation;
+      uint64_t fPermutationSeed;
+      uint64_t fFirstEvent, fEndEvent, fNextEvent; // range of permutation positions of this job
+      unsigned fPass;
+      std::unique_ptr<Py8GunPermutation> fPermutation;
+      std::unordered_set<uint64_t> used_events;
+      
+      uint64_t nextRecord();
+      bool inject( int pdgId, int status ) const;
 };
 // implementation 
 //
 Py8CSVReaderGun::Py8CSVReaderGun( edm::ParameterSet const& ps )
-   : Py8GunBase(ps), used_events({}) {
+   : Py8GunBase(ps), fNGenerated(0), fNRepeated(0), fNextEvent(0), fPass(0) {
    // ParameterSet defpset ;
    edm::ParameterSet pgun_params = 
       ps.getParameter<edm::ParameterSet>("PGunParameters"); // , defpset ) ;
@@ -44,18 +317,95 @@ Py8CSVReaderGun::Py8CSVReaderGun( edm::ParameterSet const& ps )
    fMakeDisplaced = pgun_params.getParameter<bool>("MakeDisplaced"); //, true);
    fNumParticlesPerEvent = pgun_params.getParameter<int>("NumParticlesPerEvent"); // 5
    //fNumParticlesPerEvent = 5; // 5
-   std::cout << "[Py8CSVReaderGun constructor] Begin reading CSV input file..." << std::endl;
-   std::cout << "[Py8CSVReaderGun constructor] Filename: " << fFilename << std::endl;
-   std::ifstream infile(fFilename);
-   float ee, px, py, pz;
-   while (infile >> ee >> px >> py >> pz) {
-      all_ee.push_back(ee);
-      all_px.push_back(px);
-      all_py.push_back(py);
-      all_pz.push_back(pz);
+   fVerbosity       = pgun_params.existsAs<int>("Verbosity") ? pgun_params.getParameter<int>("Verbosity") : 0;
+   fSummaryInterval = pgun_params.existsAs<unsigned>("SummaryInterval") ? pgun_params.getParameter<unsigned>("SummaryInterval") : 1000;
+   fInjectPdgIds    = pgun_params.existsAs<std::vector<int> >("InjectPdgIds") ? pgun_params.getParameter<std::vector<int> >("InjectPdgIds") : std::vector<int>();
+   fInjectStatus    = pgun_params.existsAs<std::vector<int> >("InjectStatus") ? pgun_params.getParameter<std::vector<int> >("InjectStatus") : std::vector<int>(1, 1);
+   
+   // PDG IDs and status of the rows of the E px py pz input, by default the Pluto eta -> gamma A', A' -> mu mu
+   // decays, with the gamma (2nd row) and the muons (4th and 5th rows) in the final state
+   if ( fNumParticlesPerEvent <= 0 )
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: NumParticlesPerEvent = " << fNumParticlesPerEvent
+                                            << ", it has to be at least 1";
+   Py8GunRowLayout layout;
+   layout.pdgIds = pgun_params.existsAs<std::vector<int> >("RowPdgIds") ? pgun_params.getParameter<std::vector<int> >("RowPdgIds") : std::vector<int>({0, 22, 0, 13, -13});
+   layout.status = pgun_params.existsAs<std::vector<int> >("RowStatus") ? pgun_params.getParameter<std::vector<int> >("RowStatus") : std::vector<int>({2, 1, 2, 1, 1});
+   if ( layout.pdgIds.size() != (size_t)fNumParticlesPerEvent || layout.status.size() != (size_t)fNumParticlesPerEvent )
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: RowPdgIds and RowStatus need NumParticlesPerEvent = "
+                                            << fNumParticlesPerEvent << " entries";
+   
+   fTable.reset(new Py8GunTable(fFilename, layout));
+   fNEvents = fTable->size();
+   if ( fNEvents == 0 )
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: no complete record in " << fFilename;
+   edm::LogInfo("Py8CSVReaderGun") << (fTable->mapped() ? "Mapped binary" : "Read text") << " input file " << fFilename << ": "
+                                   << fNEvents << " records, " << fTable->nParticles() << " particles";
+   
+   std::string samplingMode = pgun_params.existsAs<std::string>("SamplingMode") ? pgun_params.getParameter<std::string>("SamplingMode") : "random";
+   if ( samplingMode != "random" && samplingMode != "permutation" )
+      throw cms::Exception("Configuration") << "Py8CSVReaderGun: unknown SamplingMode " << samplingMode << ", expected random or permutation";
+   fUsePermutation = samplingMode == "permutation";
+   if ( fUsePermutation ) {
+      // without an explicit share every job would walk the same events, and the shares are only disjoint
+      // if all the jobs walk the same permutation: its seed is given apart from the generator seeds,
+      // which differ from one job to the next
+      if ( !pgun_params.existsAs<unsigned>("JobIndex") || !pgun_params.existsAs<unsigned>("NumJobs") ||
+           !pgun_params.existsAs<unsigned long long>("PermutationSeed") )
+         throw cms::Exception("Configuration") << "Py8CSVReaderGun: SamplingMode permutation needs JobIndex, NumJobs and PermutationSeed to be set for each job";
+      unsigned jobIndex = pgun_params.getParameter<unsigned>("JobIndex");
+      unsigned numJobs  = pgun_params.getParameter<unsigned>("NumJobs");
+      fPermutationSeed  = pgun_params.getParameter<unsigned long long>("PermutationSeed");
+      if ( numJobs == 0 || jobIndex >= numJobs )
+         throw cms::Exception("Configuration") << "Py8CSVReaderGun: JobIndex " << jobIndex << " not below NumJobs " << numJobs;
+      if ( fNEvents < numJobs )
+         throw cms::Exception("Configuration") << "Py8CSVReaderGun: " << fNEvents << " events in the input table for " << numJobs << " jobs";
+      fPermutation.reset(new Py8GunPermutation(fNEvents, fPermutationSeed));
+      // job i takes the positions [i*n/N, (i+1)*n/N) of the permutation, disjoint from the other jobs
+      fFirstEvent = fNEvents * jobIndex / numJobs;
+      fEndEvent   = fNEvents * (jobIndex+1) / numJobs;
+      fNextEvent  = fFirstEvent;
+      edm::LogInfo("Py8CSVReaderGun") << "Sampling the positions " << fFirstEvent << " to " << fEndEvent
+                                      << " of a permutation of the " << fNEvents << " events (seed " << fPermutationSeed << ")";
    }
-   infile.close();
-   std::cout << "[Py8CSVReaderGun constructor] Finished reading CSV input file! Size:" << all_ee.size() << std::endl;
+}
+Py8CSVReaderGun::~Py8CSVReaderGun()
+{
+   edm::LogInfo("Py8CSVReaderGun") << "Generated " << fNGenerated << " events from " << fFilename << ", "
+                                   << fNRepeated << " of them repeated";
+}
+bool Py8CSVReaderGun::inject( int pdgId, int status ) const
+{
+   if ( std::find(fInjectStatus.begin(), fInjectStatus.end(), status) == fInjectStatus.end() ) return false;
+   return fInjectPdgIds.empty() || std::find(fInjectPdgIds.begin(), fInjectPdgIds.end(), pdgId) != fInjectPdgIds.end();
+}
+// record of the next event to generate
+uint64_t Py8CSVReaderGun::nextRecord()
+{
+   if ( !fUsePermutation ) {
+      // ensure event is unique within single node (accept repetition after 100 times though)
+      // note: this of course does not apply for batch production, where probability of repetition exists
+      // (this is minimized by randomly sampling pluto list of events -- birthday problem)
+      uint64_t randomNumber;
+      int count = 0;
+      do {
+        randomNumber = (uint64_t)(fNEvents * randomEngine().flat());
+        count++;
+      }
+      while (used_events.count(randomNumber) > 0 && count < 100);
+      if ( !used_events.insert(randomNumber).second ) fNRepeated++;
+      return randomNumber;
+   }
+   
+   if ( fNextEvent == fEndEvent ) {
+      // this job's share is used up: go on with the same share of a different permutation
+      fPass++;
+      edm::LogWarning("Py8CSVReaderGun") << "All the " << fEndEvent - fFirstEvent << " events of this job used, events will repeat (pass "
+                                         << fPass << ")";
+      fPermutation.reset(new Py8GunPermutation(fPermutation->size(), fPermutationSeed + 0x632be59bd9b4e019ULL * fPass));
+      fNextEvent = fFirstEvent;
+   }
+   if ( fPass > 0 ) fNRepeated++;
+   return (*fPermutation)(fNextEvent++);
 }
 bool Py8CSVReaderGun::generatePartonsAndHadronize()
 {
@@ -67,44 +417,29 @@ bool Py8CSVReaderGun::generatePartonsAndHadronize()
    double vy = radius * sin(phi_prod);
    double vz = (70 - (-70)) * randomEngine().flat() + (-70); // luminous region in Z: (-70, 70) mm
    
-   // ensure event is unique within single node (accept repetition after 100 times though)
-   // note: this of course does not apply for batch production, where probability of repetition exists
-   // (this is minimized by randomly sampling pluto list of events -- birthday problem)
-   int randomNumber, count = 0;
-   do {
-     randomNumber = (int)(40000 * randomEngine().flat()) * fNumParticlesPerEvent;
-     //randomNumber = (int)(100 * randomEngine().flat()) * fNumParticlesPerEvent;
-     count++;
+   uint64_t record = nextRecord();
+   fNGenerated++;
+   if ( fVerbosity > 0 )
+      edm::LogVerbatim("Py8CSVReaderGun") << "Retrieving record " << record << " (" << fTable->end(record) - fTable->begin(record) << " particles)";
+   if ( fSummaryInterval > 0 && fNGenerated % fSummaryInterval == 0 )
+      edm::LogInfo("Py8CSVReaderGun") << fNGenerated << " events generated, " << fNRepeated << " repeated";
+   
+   uint64_t first = fTable->begin(record), last = fTable->end(record);
+   if ( first > last || last > fTable->nParticles() )
+      throw cms::Exception("Py8CSVReaderGun") << "Invalid offsets of record " << record << " in " << fFilename;
+   unsigned nInjected = 0;
+   for ( uint64_t i = first; i < last; i++ ) {
+      int pID = fTable->pdgId(i);
+      if ( !inject(pID, fTable->status(i)) ) continue;
+      if ( pID == 0 )
+         throw cms::Exception("Py8CSVReaderGun") << "Particle without PDG ID selected in record " << record
+                                                 << ", check InjectPdgIds or RowPdgIds";
+      double mass = (fMasterGen->particleData).m0(pID);
+      (fMasterGen->event).append(pID, 1, 0, 0, fTable->px(i), fTable->py(i), fTable->pz(i), fTable->e(i), mass); 
+      nInjected++;
    }
-   while (std::find(used_events.begin(), used_events.end(), randomNumber) != used_events.end() && count < 100);
-   used_events.push_back(randomNumber);
-   std::cout << "Retrieving CSV random event number " << randomNumber << " divided " << randomNumber/fNumParticlesPerEvent << "..." << std::endl;
-   // Get the gamma (2nd in CSV) and muons (4th and 5th in CSV) momenta
-   float ee, px, py, pz, mass, pID; 
-   // gamma
-   ee = all_ee.at(randomNumber+1);
-   px = all_px.at(randomNumber+1);
-   py = all_py.at(randomNumber+1);
-   pz = all_pz.at(randomNumber+1);
-   pID = 22;
-   mass = (fMasterGen->particleData).m0(pID);
-   (fMasterGen->event).append(pID, 1, 0, 0, px, py, pz, ee, mass); 
-   // mu plus
-   ee = all_ee.at(randomNumber+3);
-   px = all_px.at(randomNumber+3);
-   py = all_py.at(randomNumber+3);
-   pz = all_pz.at(randomNumber+3);
-   pID = 13;
-   mass = (fMasterGen->particleData).m0(pID);
-   (fMasterGen->event).append(pID, 1, 0, 0, px, py, pz, ee, mass); 
-   // mu minus
-   ee = all_ee.at(randomNumber+4);
-   px = all_px.at(randomNumber+4);
-   py = all_py.at(randomNumber+4);
-   pz = all_pz.at(randomNumber+4);
-   pID = -13;
-   mass = (fMasterGen->particleData).m0(pID);
-   (fMasterGen->event).append(pID, 1, 0, 0, px, py, pz, ee, mass); 
+   if ( nInjected == 0 )
+      throw cms::Exception("Py8CSVReaderGun") << "No particle to inject in record " << record << ", check InjectPdgIds and InjectStatus";
 
    if ( !fMasterGen->next() ) return false;
    evtGenDecay();
@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+# Convert a text table read by Py8CSVReaderGun into its binary table format, which the gun
+# memory-maps instead of parsing. The text table is either made of "record pdgId status E px py pz"
+# rows, the consecutive rows with the same record number making a record, or of "E px py pz" rows,
+# in records of a fixed number of rows whose PDG IDs and status are given with --row-pdgids and
+# --row-status (by default the Pluto eta -> gamma A', A' -> mu mu layout used by the gun).
+#
+# The binary table is made of little-endian values
+#    char   magic[8] "PY8GUNTB"
+#    uint32 version  2
+#    uint32 reserved 0
+#    uint64 nRecords
+#    uint64 nParticles
+#    uint64 offset[nRecords+1]    particles of record r at offset[r] ... offset[r+1]-1
+#    int32  pdgId[nParticles], status[nParticles]
+#    float  E[nParticles], px[nParticles], py[nParticles], pz[nParticles]
+#
+# Usage: csvToBinaryTable.py [--row-pdgids 0,22,0,13,-13] [--row-status 2,1,2,1,1] input.csv output.bin
+
+import argparse
+import array
+import struct
+import sys
+
+MAGIC   = b'PY8GUNTB'
+VERSION = 2
+
+def intList(text):
+    return [int(value) for value in text.split(',')]
+
+def convert(inname, outname, rowPdgIds, rowStatus):
+    # no 'Q' typecode in python 2, where 'L' is 64 bits on 64-bit Linux
+    offsets = array.array('Q' if array.array('L').itemsize < 8 else 'L', [0])
+    pdgIds  = array.array('i')
+    status  = array.array('i')
+    columns = [array.array('f') for i in range(4)]
+
+    def append(pdgId, st, p4):
+        pdgIds.append(pdgId)
+        status.append(st)
+        for column, value in zip(columns, p4):
+            column.append(value)
+
+    with open(inname) as infile:
+        lastRecord = None
+        for line in infile:
+            fields = line.split()
+            if not fields:
+                continue
+            if len(fields) == 7:
+                record = int(fields[0])
+                if lastRecord is not None and record != lastRecord:
+                    offsets.append(len(pdgIds))
+                lastRecord = record
+                append(int(fields[1]), int(fields[2]), [float(value) for value in fields[3:]])
+            elif len(fields) == 4:
+                row = len(pdgIds) % len(rowPdgIds)
+                append(rowPdgIds[row], rowStatus[row], [float(value) for value in fields])
+                if row == len(rowPdgIds) - 1:
+                    offsets.append(len(pdgIds))
+            else:
+                sys.exit('Rows of %d columns, expected 4 (E px py pz) or 7 (record pdgId status E px py pz)' % len(fields))
+        if lastRecord is not None:
+            offsets.append(len(pdgIds))
+
+    # same as the gun reading the text file: a trailing incomplete record is dropped
+    nparticles = offsets[-1]
+    nrecords   = len(offsets) - 1
+    for values in [pdgIds, status] + columns:
+        del values[nparticles:]
+        if sys.byteorder != 'little':
+            values.byteswap()
+    if sys.byteorder != 'little':
+        offsets.byteswap()
+
+    with open(outname, 'wb') as outfile:
+        outfile.write(struct.pack('<8sIIQQ', MAGIC, VERSION, 0, nrecords, nparticles))
+        for values in [offsets, pdgIds, status] + columns:
+            values.tofile(outfile)
+    return nrecords, nparticles
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Convert a Py8CSVReaderGun text table to its binary format')
+    parser.add_argument('--row-pdgids', type=intList, default=[0, 22, 0, 13, -13],
+                        help='PDG IDs of the rows of each record of an "E px py pz" table, 0 if unknown')
+    parser.add_argument('--row-status', type=intList, default=[2, 1, 2, 1, 1],
+                        help='status of the rows of each record of an "E px py pz" table')
+    parser.add_argument('input')
+    parser.add_argument('output')
+    args = parser.parse_args()
+    if len(args.row_pdgids) != len(args.row_status):
+        sys.exit('--row-pdgids and --row-status need the same number of entries')
+    print('Wrote %d records, %d particles to %s' % (convert(args.input, args.output, args.row_pdgids, args.row_status) + (args.output,)))